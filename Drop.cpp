@@ -16,14 +16,18 @@
  * @param c2 Critical point index for sensor2
  */
 Drop::Drop(bool isPositive, int c1, int c2)
-    : isPositive(isPositive), c1(c1), c2(c2), dataOffset(0), valid(1)
+    : isPositive(isPositive), c1(c1), c2(c2), dataOffset(0),
+      dataPerSecond(DATA_PER_SECOND), valid(1)
 {
 }
 
 /**
  * @brief Default constructor for an empty/invalid drop
  */
-Drop::Drop() : c1(-1), c2(-1), dataOffset(0), valid(0) {}
+Drop::Drop()
+    : c1(-1), c2(-1), dataOffset(0), dataPerSecond(DATA_PER_SECOND), valid(0)
+{
+}
 
 /**
  * @brief Finds the middle point of the first sensor signal
@@ -108,6 +112,8 @@ int Drop::findSensor2TippingPoint()
 void Drop::computeIntegral()
 {
     // Initialize integrals with zero
+    integralSensor1.reserve(this->size() + 1);
+    integralSensor2.reserve(this->size() + 1);
     integralSensor1.push_back(0);
     integralSensor2.push_back(0);
     
@@ -131,7 +137,7 @@ void Drop::computeIntegral()
 void Drop::computeRingCharge()
 {
     this->q1 =
-        INTEGRATION_FACTOR / DATA_PER_SECOND * this->integralSensor1[this->p1];
+        INTEGRATION_FACTOR / this->dataPerSecond * this->integralSensor1[this->p1];
 }
 
 /**
@@ -144,7 +150,7 @@ void Drop::computeRingCharge()
 void Drop::computeDishCharge()
 {
     this->q2 =
-        INTEGRATION_FACTOR / DATA_PER_SECOND * this->integralSensor2[this->p2];
+        INTEGRATION_FACTOR / this->dataPerSecond * this->integralSensor2[this->p2];
 }
 
 /**
@@ -257,6 +263,9 @@ void Drop::computeDiameter()
 
 void Drop::computeModels()
 {
+    this->a1.reserve(this->size());
+    this->b1.reserve(this->size());
+    this->a2.reserve(this->size());
     for (int i = 0; i < this->size(); i++)
     {
         this->a1.push_back(
@@ -293,7 +302,7 @@ void Drop::computeSumOfSquaredDiffPenalty()
     {
         this->sumOfSquaredDiffPenalty1 +=
             std::pow((this->a1[i] - this->integralSensor1[i] *
-                                        INTEGRATION_FACTOR / DATA_PER_SECOND) /
+                                        INTEGRATION_FACTOR / this->dataPerSecond) /
                          this->q1,
                      2);
     }
@@ -301,7 +310,7 @@ void Drop::computeSumOfSquaredDiffPenalty()
     {
         this->sumOfSquaredDiffPenalty2 +=
             std::pow((this->a2[i] - this->integralSensor2[i] *
-                                        INTEGRATION_FACTOR / DATA_PER_SECOND) /
+                                        INTEGRATION_FACTOR / this->dataPerSecond) /
                          this->q2,
                      2);
     }
@@ -496,8 +505,8 @@ void Drop::writeToFile(std::ofstream &file, bool sortedDrops)
             // integral_sensor1, integral_sensor2, a1, a2, b1, q1, q2, v, d, penalty
             file << this->time[i] << "\t" << step << "\t"
                  << this->sensor1[i] << "\t" << this->sensor2[i] << "\t"
-                 << this->integralSensor1[i] * INTEGRATION_FACTOR / DATA_PER_SECOND << "\t"
-                 << this->integralSensor2[i] * INTEGRATION_FACTOR / DATA_PER_SECOND << "\t"
+                 << this->integralSensor1[i] * INTEGRATION_FACTOR / this->dataPerSecond << "\t"
+                 << this->integralSensor2[i] * INTEGRATION_FACTOR / this->dataPerSecond << "\t"
                  << this->a1[i] << "\t" << this->a2[i] << "\t" << this->b1[i] << "\t"
                  << this->q1 << "\t" << this->q2 << "\t" << this->v << "\t" << this->d << "\t"
                  << this->penalty() << " " << this->id << "\n";
@@ -508,8 +517,8 @@ void Drop::writeToFile(std::ofstream &file, bool sortedDrops)
             // width_diff_penalty, noise_prop_penalty, penalty, id
             file << this->time[i] << "\t" << step << "\t"
                  << this->sensor1[i] << "\t" << this->sensor2[i] << "\t"
-                 << this->integralSensor1[i] * INTEGRATION_FACTOR / DATA_PER_SECOND << "\t"
-                 << this->integralSensor2[i] * INTEGRATION_FACTOR / DATA_PER_SECOND << "\t"
+                 << this->integralSensor1[i] * INTEGRATION_FACTOR / this->dataPerSecond << "\t"
+                 << this->integralSensor2[i] * INTEGRATION_FACTOR / this->dataPerSecond << "\t"
                  << this->a1[i] << "\t" << this->a2[i] << "\t" << this->b1[i] << "\t"
                  << this->q1 << "\t" << this->q2 << "\t" << this->v << "\t" << this->d << "\t"
                  << this->sumOfSquaredDiffPenalty1 << "\t" << this->sumOfSquaredDiffPenalty2 << "\t"
@@ -65,6 +65,7 @@ public:
     // === Metadata ===
     int id;          // Unique identifier for this drop
     int dataOffset;  // Starting step position in the original data file
+    double dataPerSecond; // Sample rate of the acquisition (used to integrate the charge)
     bool valid;      // Whether this drop passed all validation criteria
 
     // === Constructors ===
@@ -10,36 +10,89 @@
 #include "DropFinder.hpp"
 #include "constants.hpp"
 
+DropFinder::DropFinder(const TimeBase &timeBase)
+    : dataPerSecond(timeBase.dataPerSecond()), timeBase(timeBase),
+      sensor1Values(2 * DROP_SIZE - 1), sensor2Values(2 * DROP_SIZE - 1),
+      maxMinQueue(DROP_SIZE + 1) {}
+
 /**
  * @brief Main drop detection method that processes sensor data and returns a Drop object
  * 
  * This method implements the complete drop detection pipeline:
- * 1. Extracts sensor data from LVM buffer
- * 2. Identifies the best drop candidate using getDrop()
- * 3. Finds the starting points of the drop signature
- * 4. Extracts the drop data and analyzes key points
- * 5. Adjusts drop boundaries based on signal characteristics
- * 6. Computes all drop statistics and properties
+ * 1. Takes views of the sensor data in the LVM buffer (no copy)
+ * 2. Finds the best candidate of each polarity with getBestCandidateDrop()
+ * 3. Identifies the best drop candidate using getDrop()
+ * 4. Analyzes it with analyzeDrop()
  * 
  * @param lvm Reference to LVM buffer containing sensor data
  * @return Drop object with complete analysis results
  */
 Drop DropFinder::findDrop(const LVM &lvm)
 {
-    // Extract time, sensor1, sensor2, and used status into separate vectors
-    std::vector<double> time, sensor1, sensor2;
-    std::vector<int> used;
+    // Read sensor1, sensor2, and used status in place
+    LVM::View<double> sensor1 = lvm.sensor1();
+    LVM::View<double> sensor2 = lvm.sensor2();
+    LVM::UsedBits used = lvm.used();
+
+    // Initialize variables for both positive and negative drop candidates
+    std::pair<int, int> positiveCriticals = {-1, -1};
+    std::pair<int, int> negativeCriticals = {-1, -1};
+    double umbralp = 0.0, umbraln = 0.0; // Threshold values for each polarity
 
-    for (const auto &row : lvm)
+    // Search for best positive drop candidate
+    getBestCandidateDrop(sensor1, sensor2, used, true, positiveCriticals,
+                         umbralp);
+    // Search for best negative drop candidate
+    getBestCandidateDrop(sensor1, sensor2, used, false, negativeCriticals,
+                         umbraln);
+
+    // Find the best drop candidate in the data
+    return analyzeDrop(lvm, getDrop(positiveCriticals, umbralp, negativeCriticals, umbraln));
+}
+
+/**
+ * @brief Finds a drop in a DropWindow, reusing its per-pair values
+ * 
+ * The candidates of each polarity come from the values the window keeps
+ * up to date as rows enter it and are marked as used, instead of being
+ * rebuilt from all its rows on every call; the rest is as in findDrop.
+ * 
+ * @param window Sliding search window
+ * @return Drop object with complete analysis results
+ */
+Drop DropFinder::findDrop(DropWindow &window)
+{
+    if (!window.searchable())
     {
-        time.push_back(row.time);
-        sensor1.push_back(row.sensor1);
-        sensor2.push_back(row.sensor2);
-        used.push_back(row.used);
+        return findDrop(window.rows());
     }
 
-    // Find the best drop candidate in the data
-    Drop drop = getDrop(sensor1, sensor2, used);
+    std::pair<int, int> positiveCriticals, negativeCriticals;
+    double umbralp, umbraln;
+    window.getBestCandidateDrop(true, positiveCriticals, umbralp);
+    window.getBestCandidateDrop(false, negativeCriticals, umbraln);
+    return analyzeDrop(window.rows(),
+                       getDrop(positiveCriticals, umbralp, negativeCriticals, umbraln));
+}
+
+/**
+ * @brief Extracts and analyzes the drop of a candidate
+ * 
+ * 1. Finds the starting points of the drop signature
+ * 2. Extracts the drop data and analyzes key points
+ * 3. Adjusts drop boundaries based on signal characteristics
+ * 4. Computes all drop statistics and properties
+ * 
+ * @param lvm Rows the candidate was found in
+ * @param drop Candidate returned by getDrop
+ * @return Drop object with complete analysis results
+ */
+Drop DropFinder::analyzeDrop(const LVM &lvm, Drop drop)
+{
+    // Read tick, sensor1 and sensor2 in place
+    LVM::View<int64_t> tick = lvm.tick();
+    LVM::View<double> sensor1 = lvm.sensor1();
+    LVM::View<double> sensor2 = lvm.sensor2();
 
     // Return early if no valid drop was found
     if (!drop.valid)
@@ -51,10 +104,14 @@ Drop DropFinder::findDrop(const LVM &lvm)
     std::tie(drop.u1, drop.u2) = findStartingPoints(
         sensor1, sensor2, {drop.c1, drop.c2}, drop.isPositive);
 
-    // Extract the maximum drop size (4*NN) worth of data
+    // Extract the maximum drop size (4*NN) worth of data, the only place
+    // where ticks are turned back into times
+    drop.time.reserve(DROP_SIZE);
+    drop.sensor1.reserve(DROP_SIZE);
+    drop.sensor2.reserve(DROP_SIZE);
     for (int i = 0; i < DROP_SIZE; i++)
     {
-        drop.time.push_back(time[drop.u1 + i]);
+        drop.time.push_back(timeBase.time(tick[drop.u1 + i]));
         drop.sensor1.push_back(sensor1[drop.u1 + i]);
         drop.sensor2.push_back(sensor2[drop.u1 + i]);
     }
@@ -92,6 +149,7 @@ Drop DropFinder::findDrop(const LVM &lvm)
     drop.p2 = std::min(drop.p2, drop.size() - 1);
     drop.u1Original = drop.u1; // Store original position for reference
     drop.u1 = 0; // Reset to 0 since we trimmed from the beginning
+    drop.dataPerSecond = dataPerSecond;
     drop.computeStats(); // Calculate all drop statistics
 
     return drop;
@@ -100,32 +158,19 @@ Drop DropFinder::findDrop(const LVM &lvm)
 /**
  * @brief Identifies the best drop candidate from sensor data
  * 
- * This method analyzes the sensor data to find the strongest drop signature
- * by considering both positive and negative drop patterns. It evaluates
- * candidates from both polarities and selects the one with the strongest
- * signal that meets the detection criteria.
+ * This method selects, between the best positive and negative drop
+ * candidates, the one with the strongest signal that meets the detection
+ * criteria.
  * 
- * @param sensor1 Vector of sensor1 (ring) data
- * @param sensor2 Vector of sensor2 (dish) data
- * @param used Vector marking which data points are already used
+ * @param positiveCriticals Critical points of the best positive candidate
+ * @param umbralp Signal of the best positive candidate (0 if none)
+ * @param negativeCriticals Critical points of the best negative candidate
+ * @param umbraln Signal of the best negative candidate (0 if none)
  * @return Drop object representing the best candidate (may be invalid)
  */
-Drop DropFinder::getDrop(const std::vector<double> &sensor1,
-                         const std::vector<double> &sensor2,
-                         const std::vector<int> &used)
+Drop DropFinder::getDrop(std::pair<int, int> positiveCriticals, double umbralp,
+                         std::pair<int, int> negativeCriticals, double umbraln)
 {
-    // Initialize variables for both positive and negative drop candidates
-    std::pair<int, int> positiveCriticals = {-1, -1};
-    std::pair<int, int> negativeCriticals = {-1, -1};
-    double umbralp = 0.0, umbraln = 0.0; // Threshold values for each polarity
-
-    // Search for best positive drop candidate
-    getBestCandidateDrop(sensor1, sensor2, used, true, positiveCriticals,
-                         umbralp);
-    // Search for best negative drop candidate
-    getBestCandidateDrop(sensor1, sensor2, used, false, negativeCriticals,
-                         umbraln);
-
     // Choose the candidate with the stronger signal
     std::pair<int, int> criticals =
         umbralp != 0 && (umbraln == 0 || std::abs(umbralp) > std::abs(umbraln))
@@ -158,16 +203,16 @@ Drop DropFinder::getDrop(const std::vector<double> &sensor1,
  * 3. Evaluates each pair against detection criteria
  * 4. Returns the strongest valid candidate
  * 
- * @param sensor1 Vector of sensor1 (ring) data
- * @param sensor2 Vector of sensor2 (dish) data
- * @param used Vector marking which data points are already used
+ * @param sensor1 View of sensor1 (ring) data
+ * @param sensor2 View of sensor2 (dish) data
+ * @param used Bits marking which data points are already used
  * @param isPositive Whether to search for positive (true) or negative (false) drops
  * @param criticals Output parameter for critical point indices
  * @param umbral Output parameter for signal threshold value
  */
-void DropFinder::getBestCandidateDrop(const std::vector<double> &sensor1,
-                                      const std::vector<double> &sensor2,
-                                      const std::vector<int> &used,
+void DropFinder::getBestCandidateDrop(const LVM::View<double> &sensor1,
+                                      const LVM::View<double> &sensor2,
+                                      const LVM::UsedBits &used,
                                       bool isPositive,
                                       std::pair<int, int> &criticals,
                                       double &umbral)
@@ -179,12 +224,16 @@ void DropFinder::getBestCandidateDrop(const std::vector<double> &sensor1,
     // Calculate the maximum index we can search from
     int maxIndex = sensor1.size() - DROP_SIZE;
     
-    // Preprocess sensor data to find local extrema
-    std::vector<double> sensor1Values(sensor1.size() - 1, 0.0);
-    std::vector<double> sensor2Values(sensor1.size() - 1, 0.0);
+    // Preprocess sensor data to find local extrema, in the scratch arrays
+    // (only grown for windows larger than 2*DROP_SIZE)
+    if (sensor1Values.size() < sensor1.size() - 1)
+    {
+        sensor1Values.resize(sensor1.size() - 1);
+        sensor2Values.resize(sensor1.size() - 1);
+    }
 
     // Lambda function to extract sensor values based on polarity and usage
-    auto getValueOfSensor = [&](const std::vector<double> &sensor,
+    auto getValueOfSensor = [&](const LVM::View<double> &sensor,
                                 int i) -> double
     {
         // Skip if either point is already used
@@ -204,8 +253,9 @@ void DropFinder::getBestCandidateDrop(const std::vector<double> &sensor1,
         sensor2Values[i] = getValueOfSensor(sensor2, i);
     }
 
-    // Use MaxMinQueue for efficient sliding window operations
-    MaxMinQueue maxMinQueue;
+    // Use MaxMinQueue for efficient sliding window operations (DROP_SIZE + 1
+    // values are pushed)
+    maxMinQueue.clear();
 
     // Search backwards through the data
     for (int i = DROP_SIZE + NN; i >= NN; --i)
@@ -260,15 +310,15 @@ void DropFinder::getBestCandidateDrop(const std::vector<double> &sensor1,
  * points where the signal crosses the baseline (zero) or reaches the
  * maximum search distance (NN).
  * 
- * @param sensor1 Vector of sensor1 (ring) data
- * @param sensor2 Vector of sensor2 (dish) data
+ * @param sensor1 View of sensor1 (ring) data
+ * @param sensor2 View of sensor2 (dish) data
  * @param criticals Pair of critical point indices (c1, c2)
  * @param isPositive Whether this is a positive or negative drop
  * @return Pair of starting point indices (u1, u2)
  */
 std::pair<int, int>
-DropFinder::findStartingPoints(const std::vector<double> &sensor1,
-                               const std::vector<double> &sensor2,
+DropFinder::findStartingPoints(const LVM::View<double> &sensor1,
+                               const LVM::View<double> &sensor2,
                                std::pair<int, int> criticals, bool isPositive)
 {
     int u1 = criticals.first;  // Starting point for sensor1
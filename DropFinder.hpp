@@ -10,6 +10,7 @@
 #pragma once
 
 #include "Drop.hpp"
+#include "DropWindow.hpp"
 #include "LVM.hpp"
 #include "MaxMinQueue.hpp"
 #include "constants.hpp"
@@ -30,10 +31,24 @@
  * The detection algorithm is designed to handle both positive and negative
  * drop signatures and uses a sliding window approach with efficient data
  * structures for real-time processing.
+ * 
+ * The scratch storage of the search (the per-pair values and the
+ * MaxMinQueue) is allocated once, for a window of 2*DROP_SIZE rows, and
+ * reused by every call, so a search that finds no candidate does not
+ * allocate. The vectors of an analyzed drop are allocated at their final
+ * size.
  */
 class DropFinder
 {
 public:
+    /**
+     * @brief Constructor for a drop finder
+     * @param timeBase Time base of the data: its sample rate is used to
+     *        compute the charges, and it turns the ticks of the drop back
+     *        into times
+     */
+    explicit DropFinder(const TimeBase &timeBase = TimeBase());
+
     /**
      * @brief Main method to find a drop in the given sensor data
      * 
@@ -46,23 +61,49 @@ public:
      */
     Drop findDrop(const LVM &lvm);
 
+    /**
+     * @brief Finds a drop in a DropWindow, reusing its per-pair values
+     * 
+     * Same result as findDrop(window.rows()), which it falls back to when
+     * the window is not searchable.
+     * 
+     * @param window Sliding search window
+     * @return Drop object with detection results and properties
+     */
+    Drop findDrop(DropWindow &window);
+
+    /**
+     * @brief Extracts and analyzes the drop of a candidate
+     * 
+     * Also used by GlobalDropFinder on the candidates it picks.
+     * 
+     * @param lvm Rows the candidate was found in
+     * @param drop Candidate returned by getDrop, with c1 and c2 indexes of lvm
+     * @return Drop object with complete analysis results
+     */
+    Drop analyzeDrop(const LVM &lvm, Drop drop);
+
 private:
+    double dataPerSecond; // Sample rate of the data being scanned
+    TimeBase timeBase;    // Time base of the ticks of the data
+    std::vector<double> sensor1Values; // Per-pair sensor1 values of getBestCandidateDrop
+    std::vector<double> sensor2Values; // Per-pair sensor2 values of getBestCandidateDrop
+    MaxMinQueue maxMinQueue;           // Sliding extremes of getBestCandidateDrop
+
     /**
      * @brief Identifies the best drop candidate from sensor data
      * 
-     * This method analyzes the sensor data to find critical points that
-     * could form a drop signature. It considers both positive and negative
-     * drop patterns and returns the best candidate based on signal strength
-     * and other criteria.
+     * Chooses between the best candidates of each polarity the one with
+     * the stronger signal.
      * 
-     * @param sensor1 Vector of sensor1 (ring) data
-     * @param sensor2 Vector of sensor2 (dish) data  
-     * @param used Vector marking which data points are already used
+     * @param positiveCriticals Critical points of the best positive candidate
+     * @param umbralp Signal of the best positive candidate (0 if none)
+     * @param negativeCriticals Critical points of the best negative candidate
+     * @param umbraln Signal of the best negative candidate (0 if none)
      * @return Drop object representing the best candidate (may be invalid)
      */
-    Drop getDrop(const std::vector<double> &sensor1,
-                 const std::vector<double> &sensor2,
-                 const std::vector<int> &used);
+    Drop getDrop(std::pair<int, int> positiveCriticals, double umbralp,
+                 std::pair<int, int> negativeCriticals, double umbraln);
 
     /**
      * @brief Finds the best drop candidate for a specific polarity
@@ -71,16 +112,16 @@ private:
      * (positive or negative) and evaluates them to find the strongest
      * signal that meets the detection criteria.
      * 
-     * @param sensor1 Vector of sensor1 (ring) data
-     * @param sensor2 Vector of sensor2 (dish) data
-     * @param used Vector marking which data points are already used
+     * @param sensor1 View of sensor1 (ring) data
+     * @param sensor2 View of sensor2 (dish) data
+     * @param used Bits marking which data points are already used
      * @param isPositive Whether to search for positive (true) or negative (false) drops
      * @param criticals Output parameter for critical point indices
      * @param umbral Output parameter for signal threshold value
      */
-    void getBestCandidateDrop(const std::vector<double> &sensor1,
-                              const std::vector<double> &sensor2,
-                              const std::vector<int> &used, bool isPositive,
+    void getBestCandidateDrop(const LVM::View<double> &sensor1,
+                              const LVM::View<double> &sensor2,
+                              const LVM::UsedBits &used, bool isPositive,
                               std::pair<int, int> &criticals, double &umbral);
 
     /**
@@ -90,14 +131,14 @@ private:
      * traces backwards to find the actual starting points of the drop
      * signal, which are used to define the complete drop region.
      * 
-     * @param sensor1 Vector of sensor1 (ring) data
-     * @param sensor2 Vector of sensor2 (dish) data
+     * @param sensor1 View of sensor1 (ring) data
+     * @param sensor2 View of sensor2 (dish) data
      * @param criticals Pair of critical point indices
      * @param isPositive Whether this is a positive or negative drop
      * @return Pair of starting point indices (u1, u2)
      */
-    std::pair<int, int> findStartingPoints(const std::vector<double> &sensor1,
-                                           const std::vector<double> &sensor2,
+    std::pair<int, int> findStartingPoints(const LVM::View<double> &sensor1,
+                                           const LVM::View<double> &sensor2,
                                            std::pair<int, int> criticals,
                                            bool isPositive);
 };
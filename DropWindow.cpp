@@ -0,0 +1,274 @@
+/**
+ * @file DropWindow.cpp
+ * @brief Implementation of the DropWindow class
+ */
+
+#include "DropWindow.hpp"
+
+void DropWindow::Range::add(size_t from, size_t to)
+{
+    if (from >= to)
+        return;
+    first = first == last ? from : std::min(first, from);
+    last = std::max(last, to);
+}
+
+void DropWindow::Range::dropBefore(size_t pair)
+{
+    first = std::max(first, pair);
+    last = std::max(first, last);
+}
+
+DropWindow::DropWindow()
+    : window(2 * DROP_SIZE), previous{0, 0, 0, 0}, added(0), nonFinite(0), lastActive2(0)
+{
+    for (Polarity &polarity : polarities)
+    {
+        polarity.pair1.resize(CAPACITY);
+        polarity.pair2.resize(CAPACITY);
+        polarity.extreme2.resize(CAPACITY);
+        polarity.extremeAt.resize(CAPACITY);
+        polarity.queue.pairs.resize(CAPACITY);
+    }
+    scratch.pairs.resize(CAPACITY);
+    triggers.pairs.resize(CAPACITY);
+}
+
+size_t DropWindow::start() const { return added - window.size(); }
+
+size_t DropWindow::size() const { return window.size(); }
+
+size_t DropWindow::totalUsed() const { return window.totalUsed; }
+
+const LVM &DropWindow::rows() const { return window; }
+
+void DropWindow::usedFlags(uint64_t *flags) const
+{
+    // The ring holds a whole number of words, so 64 rows from any slot
+    // span at most two of them
+    LVM::UsedBits used = window.used();
+    size_t wordMask = used.mask >> 6;
+    for (size_t k = 0; k < FLAG_WORDS; k++)
+    {
+        size_t slot = (used.head + 64 * k) & used.mask;
+        size_t shift = slot & 63;
+        uint64_t bits = used.words[slot >> 6] >> shift;
+        if (shift != 0)
+            bits |= used.words[((slot >> 6) + 1) & wordMask] << (64 - shift);
+        size_t rows = used.size() > 64 * k ? std::min<size_t>(64, used.size() - 64 * k) : 0;
+        flags[k] = rows == 64 ? bits : bits & ((uint64_t(1) << rows) - 1);
+    }
+}
+
+bool DropWindow::searchable() const
+{
+    return window.size() == 2 * DROP_SIZE && nonFinite == 0;
+}
+
+bool DropWindow::quiet() const
+{
+    return nonFinite == 0 &&
+           (triggers.head == triggers.tail ||
+            triggers.pairs[triggers.head & MASK] >= start() + DROP_SIZE);
+}
+
+void DropWindow::storePair(size_t p, const LVM::Row &first, const LVM::Row &second,
+                           bool isUsed)
+{
+    // Same values as getValueOfSensor in DropFinder::getBestCandidateDrop
+    size_t slot = p & MASK;
+    polarities[0].pair1[slot] = isUsed ? 0 : std::min(first.sensor1, second.sensor1);
+    polarities[0].pair2[slot] = isUsed ? 0 : std::min(first.sensor2, second.sensor2);
+    polarities[1].pair1[slot] = isUsed ? 0 : std::max(first.sensor1, second.sensor1);
+    polarities[1].pair2[slot] = isUsed ? 0 : std::max(first.sensor2, second.sensor2);
+}
+
+void DropWindow::updatePair(size_t p)
+{
+    size_t i = p - start();
+    LVM::UsedBits used = window.used();
+    storePair(p, window[i], window[i + 1], used[i] || used[i + 1]);
+}
+
+void DropWindow::enqueue(Queue &queue, const Polarity &polarity, bool isPositive, size_t p)
+{
+    double value = polarity.pair2[p & MASK];
+    while (queue.tail != queue.head)
+    {
+        double last = polarity.pair2[queue.pairs[(queue.tail - 1) & MASK] & MASK];
+        if (isPositive ? !(last < value) : !(last > value))
+            break;
+        queue.tail--;
+    }
+    queue.pairs[queue.tail++ & MASK] = p;
+}
+
+void DropWindow::storeExtreme(Queue &queue, Polarity &polarity, size_t p)
+{
+    while (queue.pairs[queue.head & MASK] < p)
+    {
+        queue.head++;
+    }
+    size_t extreme = queue.pairs[queue.head & MASK];
+    polarity.extreme2[p & MASK] = polarity.pair2[extreme & MASK];
+    polarity.extremeAt[p & MASK] = extreme;
+}
+
+void DropWindow::addSensorData(const LVM::Row &row)
+{
+    // The oldest row leaves the window when it is full
+    if (window.size() == 2 * DROP_SIZE &&
+        (!std::isfinite(window.sensor1()[0]) || !std::isfinite(window.sensor2()[0])))
+    {
+        nonFinite--;
+    }
+    window.addSensorData(row);
+    added++;
+    if (!std::isfinite(row.sensor1) || !std::isfinite(row.sensor2))
+    {
+        nonFinite++;
+    }
+
+    // The new row completes a pair, which completes the NN pairs after a pair
+    if (added >= 2)
+    {
+        size_t p = added - 2;
+        LVM::UsedBits used = window.used();
+        storePair(p, previous, row, used[window.size() - 2] || used[window.size() - 1]);
+        for (size_t k = 0; k < 2; k++)
+        {
+            Polarity &polarity = polarities[k];
+            enqueue(polarity.queue, polarity, k == 0, p);
+            if (p + 1 >= NN)
+            {
+                storeExtreme(polarity.queue, polarity, p + 1 - NN);
+            }
+        }
+    }
+    previous = row;
+
+    // Row r - NN is a trigger when a sensor2 of [r - NN, r] is beyond the
+    // threshold; rows before the searched range no longer matter
+    size_t r = added - 1;
+    if (!(std::abs(row.sensor2) <= MINIMUM_THRESHOLD))
+    {
+        lastActive2 = r + 1;
+    }
+    if (r >= NN && lastActive2 > r - NN &&
+        !(std::abs(window.sensor1()[window.size() - 1 - NN]) <= MINIMUM_THRESHOLD))
+    {
+        triggers.pairs[triggers.tail++ & MASK] = r - NN;
+    }
+    while (triggers.head != triggers.tail && triggers.pairs[triggers.head & MASK] < start() + NN)
+    {
+        triggers.head++;
+    }
+}
+
+void DropWindow::setUsed(size_t r1, size_t r2)
+{
+    window.setUsed(r1, r2);
+    if (r1 > r2 || added < 2)
+    {
+        return;
+    }
+
+    // Pairs [first, last) have a row in the range
+    size_t lastPair = added - 2;
+    size_t first = start() + r1 - (r1 > 0 ? 1 : 0);
+    size_t last = std::min(start() + r2, lastPair) + 1;
+
+    // Those still in the queues (and the queues) are recomputed now, the
+    // others, and the extremes computed over them, when searched
+    size_t queued = lastPair + 1 >= NN ? lastPair + 1 - NN : 0;
+    stalePairs.add(first, std::min(last, queued));
+    if (lastPair + 1 >= NN)
+    {
+        staleExtremes.add(first + 1 >= NN ? first + 1 - NN : 0, std::min(last, queued + 1));
+    }
+    if (last <= queued)
+    {
+        return;
+    }
+    for (size_t p = std::max(first, queued); p < last; p++)
+    {
+        updatePair(p);
+    }
+    for (size_t k = 0; k < 2; k++)
+    {
+        Polarity &polarity = polarities[k];
+        polarity.queue.head = polarity.queue.tail = 0;
+        for (size_t p = queued; p <= lastPair; p++)
+        {
+            enqueue(polarity.queue, polarity, k == 0, p);
+        }
+    }
+}
+
+void DropWindow::updateExtremes(size_t first, size_t last)
+{
+    for (size_t k = 0; k < 2; k++)
+    {
+        Polarity &polarity = polarities[k];
+        scratch.head = scratch.tail = 0;
+        for (size_t p = first; p < last + NN - 1; p++)
+        {
+            enqueue(scratch, polarity, k == 0, p);
+            if (p + 1 >= first + NN)
+            {
+                storeExtreme(scratch, polarity, p + 1 - NN);
+            }
+        }
+    }
+}
+
+void DropWindow::getBestCandidateDrop(bool isPositive, std::pair<int, int> &criticals,
+                                      double &umbral)
+{
+    // Initialize output parameters
+    criticals = {-1, -1};
+    umbral = 0.0;
+
+    // Candidates are the pairs [NN, DROP_SIZE) of the window, and their
+    // extremes reach NN - 1 pairs further; the stale values before them are
+    // never searched again
+    size_t first = start();
+    size_t lastRead = first + DROP_SIZE + NN - 1;
+    for (size_t p = std::max(stalePairs.first, first + NN);
+         p < std::min(stalePairs.last, lastRead); p++)
+    {
+        updatePair(p);
+    }
+    stalePairs.dropBefore(lastRead);
+    size_t from = std::max(staleExtremes.first, first + NN);
+    size_t to = std::min(staleExtremes.last, first + DROP_SIZE);
+    if (from < to)
+    {
+        updateExtremes(from, to);
+    }
+    staleExtremes.dropBefore(first + DROP_SIZE);
+
+    // Same scan as DropFinder::getBestCandidateDrop, without rebuilding
+    // the pairs and the queue
+    const Polarity &polarity = polarities[isPositive ? 0 : 1];
+    for (int i = DROP_SIZE - 1; i >= NN; --i)
+    {
+        size_t slot = (first + i) & MASK;
+        double sensor2Value = polarity.extreme2[slot];
+        double value = isPositive ? std::min(polarity.pair1[slot], sensor2Value)
+                                  : std::max(polarity.pair1[slot], sensor2Value);
+
+        // Skip if value doesn't match expected polarity
+        if (isPositive && value < 0)
+            continue;
+        if (!isPositive && value > 0)
+            continue;
+
+        // Check if this is the best candidate so far
+        if (MINIMUM_THRESHOLD < std::abs(value) && std::abs(umbral) < std::abs(value))
+        {
+            umbral = value;
+            criticals = {i, static_cast<int>(polarity.extremeAt[slot] - first)};
+        }
+    }
+}
@@ -0,0 +1,234 @@
+/**
+ * @file DropWindow.hpp
+ * @brief Header file for the DropWindow class - incremental drop search window
+ *
+ * The drop search looks at a window of 2*DROP_SIZE rows that slides one row
+ * at a time. For each polarity it needs, for every pair of consecutive rows,
+ * the smaller (or larger) value of each sensor, and for sensor2 the extreme
+ * of those over the next NN pairs. DropWindow keeps these values from one
+ * window to the next instead of rebuilding them on every search: a new row
+ * adds one pair and one extreme, and marking rows as used only recomputes
+ * the values of the pairs it touches.
+ */
+
+#pragma once
+
+#include "LVM.hpp"
+#include "constants.hpp"
+#include "lib.hpp"
+
+/**
+ * @class DropWindow
+ * @brief Sliding window of 2*DROP_SIZE rows with the per-pair values of the search
+ *
+ * Rows are numbered from the first one ever added; pair p is made of rows
+ * p and p + 1 and its values are 0 when either row is used, as in
+ * DropFinder. The values are kept in rings indexed by pair number, and the
+ * extremes of sensor2 over NN pairs are computed with a monotonic queue
+ * as the pairs arrive.
+ *
+ * setUsed marks the pairs it touches, and the extremes over them, as
+ * stale; stale values are recomputed when a search reads them, so marking
+ * the first half of the window, which is never searched again, costs
+ * nothing. Only the pairs still in the queues are recomputed right away.
+ *
+ * As rows arrive it also notes the trigger rows: those whose sensor1 is
+ * beyond MINIMUM_THRESHOLD with a sensor2 beyond it in the NN rows from
+ * it. Every drop candidate of the search is the pair of a trigger row, so
+ * a window without one in the searched range is quiet and need not be
+ * searched.
+ */
+class DropWindow
+{
+public:
+    /**
+     * @brief Constructor for an empty window
+     */
+    DropWindow();
+
+    /**
+     * @brief Adds a row at the end of the window, dropping the oldest one when full
+     * @param row Row to add
+     */
+    void addSensorData(const LVM::Row &row);
+
+    /**
+     * @brief Marks a range of rows as used
+     * @param r1 Start index of the range (0 is the oldest row)
+     * @param r2 End index of the range (inclusive)
+     * @throws std::out_of_range if r2 is past the last row
+     */
+    void setUsed(size_t r1, size_t r2);
+
+    /**
+     * @brief Returns the number of rows in the window
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the number of used rows in the window
+     */
+    size_t totalUsed() const;
+
+    /**
+     * @brief Returns the rows of the window
+     */
+    const LVM &rows() const;
+
+    // Words of the used flags of a full window
+    static constexpr size_t FLAG_WORDS = (2 * DROP_SIZE + 63) / 64;
+
+    /**
+     * @brief Copies the used flags of the window, packed 64 rows per word
+     *
+     * The search of the window only depends on its rows and these flags:
+     * two windows over the same rows with the same flags find the same
+     * drops from then on.
+     *
+     * @param flags Output flags, FLAG_WORDS words, bit (i % 64) of word
+     *        i / 64 for row i (0 past the last row)
+     */
+    void usedFlags(uint64_t *flags) const;
+
+    /**
+     * @brief Checks whether the incremental search can be used
+     *
+     * It needs a full window without NaN or infinite values (the
+     * comparisons of the search do not order those).
+     */
+    bool searchable() const;
+
+    /**
+     * @brief Checks whether a full window is quiet
+     *
+     * A quiet window has no trigger row in the range the search takes its
+     * candidates from (rows NN to DROP_SIZE - 1), so the search would find
+     * no candidate there: findDrop would return an empty Drop. A window
+     * with NaN or infinite values is never quiet (the search does not
+     * order them, so they can make a candidate of any row).
+     */
+    bool quiet() const;
+
+    /**
+     * @brief Finds the best drop candidate of one polarity
+     *
+     * Same result as DropFinder::getBestCandidateDrop on rows(), which
+     * must be searchable().
+     *
+     * @param isPositive Whether to search for positive (true) or negative (false) drops
+     * @param criticals Output parameter for critical point indices
+     * @param umbral Output parameter for signal threshold value
+     */
+    void getBestCandidateDrop(bool isPositive, std::pair<int, int> &criticals,
+                              double &umbral);
+
+private:
+    // Size of the rings, a power of two holding every pair of a window
+    static constexpr size_t CAPACITY = 1024;
+    static constexpr size_t MASK = CAPACITY - 1;
+    static_assert(CAPACITY >= 2 * DROP_SIZE, "DropWindow rings too small");
+
+    /**
+     * @struct Queue
+     * @brief Monotonic queue of pair numbers, by position & MASK
+     */
+    struct Queue
+    {
+        std::vector<size_t> pairs; // Pair numbers
+        size_t head = 0;           // Position of the first pair
+        size_t tail = 0;           // Position after the last pair
+    };
+
+    /**
+     * @struct Polarity
+     * @brief Values of the pairs for one polarity, by pair number & MASK
+     */
+    struct Polarity
+    {
+        std::vector<double> pair1;     // min (positive) or max (negative) of sensor1
+        std::vector<double> pair2;     // Same for sensor2
+        std::vector<double> extreme2;  // max (positive) or min (negative) of pair2 over [p, p + NN)
+        std::vector<size_t> extremeAt; // Pair of extreme2 (the first one on ties)
+        Queue queue;                   // Pairs that can still be extreme2 of the next pairs
+    };
+
+    /**
+     * @struct Range
+     * @brief Range of pairs [first, last) whose values may be stale
+     */
+    struct Range
+    {
+        size_t first = 0; // First pair
+        size_t last = 0;  // Pair after the last one (first when empty)
+
+        /**
+         * @brief Extends the range to cover [from, to) too
+         */
+        void add(size_t from, size_t to);
+
+        /**
+         * @brief Removes the pairs before a pair from the range
+         */
+        void dropBefore(size_t pair);
+    };
+
+    LVM window;             // Rows of the window
+    Polarity polarities[2]; // Positive and negative
+    Queue scratch;          // Queue of updateExtremes
+    LVM::Row previous;      // Last row added
+    size_t added;           // Rows added so far
+    size_t nonFinite;       // Rows of the window with a NaN or infinite sensor
+    Range stalePairs;       // Pairs whose pair1 and pair2 may be stale
+    Range staleExtremes;    // Pairs whose extreme2 may be stale
+    Queue triggers;         // Trigger rows of the searched range and after, in order
+    size_t lastActive2;     // Row after the last one with sensor2 beyond MINIMUM_THRESHOLD (0 if none)
+
+    /**
+     * @brief Returns the number of the oldest row of the window
+     */
+    size_t start() const;
+
+    /**
+     * @brief Stores the values of a pair
+     * @param p Pair number
+     * @param first Row p
+     * @param second Row p + 1
+     * @param isUsed Whether either row is used
+     */
+    void storePair(size_t p, const LVM::Row &first, const LVM::Row &second, bool isUsed);
+
+    /**
+     * @brief Computes the values of a pair from the rows of the window
+     * @param p Pair number
+     */
+    void updatePair(size_t p);
+
+    /**
+     * @brief Adds a pair at the end of a monotonic queue
+     *
+     * Drops the pairs before it whose pair2 is worse (smaller for the
+     * positive polarity, larger for the negative one), so the first pair of
+     * the queue is the extreme one and, on ties, the oldest.
+     *
+     * @param queue Queue of the polarity
+     * @param polarity Values of the pairs
+     * @param isPositive Whether the polarity is the positive one
+     * @param p Pair number
+     */
+    static void enqueue(Queue &queue, const Polarity &polarity, bool isPositive, size_t p);
+
+    /**
+     * @brief Stores the extreme of the queue as extreme2 of a pair
+     * @param queue Queue holding the pairs [p, p + NN) (and none before p after the call)
+     * @param polarity Values of the pairs
+     * @param p Pair number
+     */
+    static void storeExtreme(Queue &queue, Polarity &polarity, size_t p);
+
+    /**
+     * @brief Recomputes extreme2 of a range of pairs
+     * @param first First pair
+     * @param last Pair after the last one
+     */
+    void updateExtremes(size_t first, size_t last);
+};
@@ -0,0 +1,150 @@
+/**
+ * @file GapFiller.cpp
+ * @brief Implementation of the GapFiller class
+ */
+
+#include "GapFiller.hpp"
+
+GapFiller::GapFiller(const TimeBase &timeBase)
+    : summedFirst(0), summedLast(0), firstRow(0), next(0), released(0), timeBase(timeBase)
+{
+    // The ranges averaged never span more than the left window, the row
+    // after a gap and the right window
+    size_t capacity = 1;
+    while (capacity < 2 * FILL_WINDOW_SIZE + 1)
+    {
+        capacity *= 2;
+    }
+    sums.resize(capacity);
+    mask = capacity - 1;
+}
+
+void GapFiller::push(const LVM::Row &row, std::vector<LVM::Row> &output)
+{
+    rows.push_back(row);
+    release(false, output);
+}
+
+void GapFiller::finish(std::vector<LVM::Row> &output)
+{
+    release(true, output);
+}
+
+GapFiller::Sums GapFiller::sumsBefore(size_t row) const
+{
+    return row == summedFirst ? Sums() : sums[(row - 1) & mask];
+}
+
+void GapFiller::average(size_t first, size_t last, double &sensor1, double &sensor2)
+{
+    size_t from = firstRow + first;
+    size_t to = firstRow + last;
+    if (from < summedFirst || summedLast < firstRow ||
+        (from > summedLast && from - summedLast >= last - first))
+    {
+        summedFirst = from;
+        summedLast = from;
+        total = Sums();
+    }
+    for (; summedLast < to; summedLast++)
+    {
+        total.add(rows[summedLast - firstRow]);
+        sums[summedLast & mask] = total;
+    }
+
+    // Differences of the prefix sums are the exact window sums
+    Sums before = sumsBefore(from);
+    Sums through = sumsBefore(to);
+    Sums window;
+    window.sensor1 = through.sensor1 - before.sensor1;
+    window.sensor2 = through.sensor2 - before.sensor2;
+    window.invalid = through.invalid - before.invalid;
+    size_t count = last - first;
+    if (window.invalid == 0)
+    {
+        window.means(count, sensor1, sensor2);
+        return;
+    }
+
+    sensor1 = 0;
+    sensor2 = 0;
+    for (size_t j = first; j < last; j++)
+    {
+        sensor1 += rows[j].sensor1;
+        sensor2 += rows[j].sensor2;
+    }
+    sensor1 /= count;
+    sensor2 /= count;
+}
+
+void GapFiller::release(bool finishing, std::vector<LVM::Row> &output)
+{
+    size_t halfWindow = FILL_WINDOW_SIZE;
+
+    while (next < rows.size())
+    {
+        size_t i = next;
+        // Check if there's a gap in the data (tick difference too large)
+        if (i > 0 && rows[i].tick - rows[i - 1].tick > MAX_TICK_DIFF)
+        {
+            // Wait for the whole window after the gap
+            if (!finishing && rows.size() < i + halfWindow)
+            {
+                return;
+            }
+            int64_t diff = rows[i].tick - rows[i - 1].tick;
+
+            // One data point for every missing tick
+            size_t numberOfLinesToFill = diff - 1;
+
+            // Average values of the left window (before the gap) and the
+            // right window (after the gap, the row after it excluded)
+            double leftAvgSensor1, leftAvgSensor2;
+            double rightAvgSensor1, rightAvgSensor2;
+            average(i < halfWindow ? 0 : i - halfWindow, i, leftAvgSensor1, leftAvgSensor2);
+            average(std::min(rows.size(), i + 1), std::min(rows.size(), i + halfWindow),
+                    rightAvgSensor1, rightAvgSensor2);
+
+            // Fill the gap using linear interpolation
+            for (size_t j = 0; j < numberOfLinesToFill; j++)
+            {
+                // Linear interpolation between left and right averages
+                double fraction = static_cast<double>(j + 1) / diff;
+                double sensor1 = leftAvgSensor1 + (rightAvgSensor1 - leftAvgSensor1) * fraction;
+                double sensor2 = leftAvgSensor2 + (rightAvgSensor2 - leftAvgSensor2) * fraction;
+                output.push_back(LVM::Row{rows[i - 1].tick + static_cast<int64_t>(j + 1),
+                                          sensor1, sensor2, 0});
+            }
+            gaps.push_back(Gap{rows[i - 1].tick, released, numberOfLinesToFill,
+                               leftAvgSensor1, leftAvgSensor2,
+                               rightAvgSensor1, rightAvgSensor2});
+            released += numberOfLinesToFill;
+        }
+        // Add the original data point
+        output.push_back(rows[i]);
+        released++;
+        next++;
+
+        // Keep only the rows the left window of a later gap can reach
+        if (next > halfWindow)
+        {
+            rows.pop_front();
+            firstRow++;
+            next--;
+        }
+    }
+}
+
+void GapFiller::writeGaps(std::ostream &file)
+{
+    if (gaps.empty())
+        return;
+    file << std::fixed << std::setprecision(6);
+    for (const Gap &gap : gaps)
+    {
+        file << timeBase.time(gap.tick) << "\t" << gap.position << "\t" << gap.length << "\t"
+             << gap.sensor1Before << "\t" << gap.sensor2Before << "\t"
+             << gap.sensor1After << "\t" << gap.sensor2After << "\n";
+    }
+    gaps.clear();
+}
@@ -0,0 +1,132 @@
+/**
+ * @file GapFiller.hpp
+ * @brief Header file for the GapFiller class - incremental gap filling
+ *
+ * The acquisition sometimes loses samples. Each gap is filled with a
+ * linear interpolation between the average of the FILL_WINDOW_SIZE samples
+ * before it and the FILL_WINDOW_SIZE - 1 samples after it. GapFiller does
+ * this one row at a time, so the same code serves both a whole file and a
+ * file that is still being written. Every gap filled is also recorded for
+ * the gaps.dat report.
+ */
+
+#pragma once
+
+#include "LVM.hpp"
+#include "constants.hpp"
+#include "lib.hpp"
+#include "normalizer.hpp"
+
+/**
+ * @class GapFiller
+ * @brief Stateful gap filling stage
+ *
+ * Rows are pushed in time order and come out, together with the rows that
+ * fill the gaps, in the same order. Gaps are found on the integer
+ * difference of the ticks of consecutive rows, so whether a step is a gap
+ * never depends on how the times were rounded. A row that follows a gap is held back
+ * until the window after it is complete (at most FILL_WINDOW_SIZE - 1
+ * rows); any other row comes out as soon as it is pushed. The output is
+ * identical to filling the whole signal at once.
+ *
+ * The window averages come from prefix sums of the exact sums of the
+ * normalizer (normalizer::WindowSums), so they never drift and a gap
+ * costs the same whatever FILL_WINDOW_SIZE is. The prefix sums only run
+ * over the rows around gaps: they are extended when a gap needs an
+ * average past their last row, and started over at its window when they
+ * do not reach back to it, so a row far from any gap costs nothing.
+ * Windows holding a NaN or a value too large for the sums are summed row
+ * by row instead.
+ */
+class GapFiller
+{
+public:
+    /**
+     * @struct Gap
+     * @brief A gap that was filled
+     */
+    struct Gap
+    {
+        int64_t tick;          // Tick of the last sample before the gap
+        size_t position;       // Index of the first added row in the filled signal
+        size_t length;         // Number of rows added
+        double sensor1Before;  // Average of sensor1 before the gap
+        double sensor2Before;  // Average of sensor2 before the gap
+        double sensor1After;   // Average of sensor1 after the gap
+        double sensor2After;   // Average of sensor2 after the gap
+    };
+
+    static constexpr int64_t MAX_TICK_DIFF = 2; // Tick step above which there is a gap
+
+    /**
+     * @brief Constructor for a gap filler
+     * @param timeBase Time base of the rows, for the times of the gaps report
+     */
+    explicit GapFiller(const TimeBase &timeBase = TimeBase());
+
+    /**
+     * @brief Pushes the next row of the signal
+     * @param row Next row, in time order
+     * @param output Rows ready to be used are appended here
+     */
+    void push(const LVM::Row &row, std::vector<LVM::Row> &output);
+
+    /**
+     * @brief Releases the rows held back at the end of the signal
+     * @param output Remaining rows are appended here
+     */
+    void finish(std::vector<LVM::Row> &output);
+
+    /**
+     * @brief Writes the gaps filled since the last call, one line per gap
+     *
+     * Columns: time before the gap, position in the filled signal, rows
+     * added, and the sensor1/sensor2 averages before and after the gap
+     * (the fill goes linearly from the former to the latter).
+     *
+     * @param file Output stream of the gaps report
+     */
+    void writeGaps(std::ostream &file);
+
+private:
+    using Sums = normalizer::WindowSums;
+
+    std::deque<LVM::Row> rows; // FILL_WINDOW_SIZE rows already released + rows held back
+    std::vector<Sums> sums;    // Prefix sums through each summed row, as a ring
+    size_t mask;               // Ring index mask (capacity of sums - 1)
+    Sums total;                // Prefix sums through the last row summed
+    size_t summedFirst;        // Index in the signal of the row the prefix sums start at
+    size_t summedLast;         // Index in the signal past the last row summed
+    size_t firstRow;           // Index in the signal of rows.front()
+    size_t next;               // Index in rows of the first row not released yet
+    size_t released;           // Rows released so far, added ones included
+    TimeBase timeBase;         // Time base of the rows
+    std::vector<Gap> gaps;     // Gaps filled and not written yet
+
+    /**
+     * @brief Returns the prefix sums before a summed row
+     * @param row Index in the signal, from summedFirst to summedLast
+     */
+    Sums sumsBefore(size_t row) const;
+
+    /**
+     * @brief Averages the sensors of a range of rows
+     *
+     * Extends the prefix sums through the range first, or starts them over
+     * at the range when they do not reach back to it (or it is cheaper
+     * than summing the rows in between).
+     *
+     * @param first Index in rows of the first row
+     * @param last Index in rows past the last row
+     * @param sensor1 Output average of sensor1 (NaN for an empty range)
+     * @param sensor2 Output average of sensor2 (NaN for an empty range)
+     */
+    void average(size_t first, size_t last, double &sensor1, double &sensor2);
+
+    /**
+     * @brief Releases the rows that no longer need more rows after them
+     * @param finishing True at the end of the signal
+     * @param output Released rows are appended here
+     */
+    void release(bool finishing, std::vector<LVM::Row> &output);
+};
@@ -0,0 +1,243 @@
+/**
+ * @file GlobalDropFinder.cpp
+ * @brief Implementation of the GlobalDropFinder class
+ */
+
+#include "GlobalDropFinder.hpp"
+
+GlobalDropFinder::GlobalDropFinder(const TimeBase &timeBase)
+    : dropFinder(timeBase), marked(0), rows(NN + DROP_SIZE), ticks(NN + DROP_SIZE),
+      sensor1(NN + DROP_SIZE), sensor2(NN + DROP_SIZE)
+{
+}
+
+double GlobalDropFinder::pairValue(double first, double second, bool isPositive)
+{
+    if (!std::isfinite(first) || !std::isfinite(second))
+        return 0;
+    return isPositive ? std::min(first, second) : std::max(first, second);
+}
+
+bool GlobalDropFinder::weaker(const Candidate &a, const Candidate &b)
+{
+    if (a.strength != b.strength)
+        return a.strength < b.strength;
+    if (a.pair != b.pair)
+        return a.pair < b.pair;
+    return a.isPositive && !b.isPositive;
+}
+
+bool GlobalDropFinder::anyUsed(size_t first, size_t last) const
+{
+    for (size_t r = first; r <= last; r++)
+    {
+        if (used[r])
+            return true;
+    }
+    return false;
+}
+
+void GlobalDropFinder::setUsed(size_t first, size_t last)
+{
+    for (size_t r = first; r <= last && r < used.size(); r++)
+    {
+        used[r] = true;
+    }
+    marked++;
+}
+
+std::vector<GlobalDropFinder::Candidate>
+GlobalDropFinder::findCandidates(const SampleBuffer &signal, CLI &cli)
+{
+    std::vector<Candidate> candidates;
+    size_t rows = signal.size();
+    cli.startProgress("find_candidates", "Finding drop candidates", rows);
+
+    // Per polarity: ring of the pair values and monotonic queue of the
+    // pairs that can still be the extreme sensor2 value of a later pair
+    double pair1[2][CAPACITY], pair2[2][CAPACITY];
+    size_t queue[2][CAPACITY];
+    size_t head[2] = {0, 0}, tail[2] = {0, 0};
+
+    std::vector<int64_t> ticks(BLOCK_ROWS);
+    std::vector<double> sensor1(BLOCK_ROWS), sensor2(BLOCK_ROWS);
+    double previous1 = 0, previous2 = 0;
+    for (size_t first = 0; first < rows; first += BLOCK_ROWS)
+    {
+        size_t count = std::min(BLOCK_ROWS, rows - first);
+        signal.read(first, count, ticks.data(), sensor1.data(), sensor2.data());
+        for (size_t k = 0; k < count; k++)
+        {
+            size_t r = first + k;
+            if (r > 0)
+            {
+                // Pair p of rows p and p + 1 is complete
+                size_t p = r - 1;
+                for (int polarity = 0; polarity < 2; polarity++)
+                {
+                    bool isPositive = polarity == 0;
+                    double value = pairValue(previous2, sensor2[k], isPositive);
+                    pair1[polarity][p & MASK] = pairValue(previous1, sensor1[k], isPositive);
+                    pair2[polarity][p & MASK] = value;
+
+                    // Drop the pairs before it with a worse value, so the
+                    // first pair of the queue is the extreme (and on ties
+                    // the oldest) one
+                    while (tail[polarity] != head[polarity])
+                    {
+                        double last = pair2[polarity][queue[polarity][(tail[polarity] - 1) & MASK] & MASK];
+                        if (isPositive ? !(last < value) : !(last > value))
+                            break;
+                        tail[polarity]--;
+                    }
+                    queue[polarity][tail[polarity]++ & MASK] = p;
+                    if (p + 1 < NN)
+                        continue;
+
+                    // The queue now covers the pairs [q, q + NN)
+                    size_t q = p + 1 - NN;
+                    while (queue[polarity][head[polarity] & MASK] < q)
+                    {
+                        head[polarity]++;
+                    }
+                    if (q < NN || q + DROP_SIZE > rows)
+                        continue;
+                    size_t extremeAt = queue[polarity][head[polarity] & MASK];
+                    double combined = isPositive
+                                          ? std::min(pair1[polarity][q & MASK], pair2[polarity][extremeAt & MASK])
+                                          : std::max(pair1[polarity][q & MASK], pair2[polarity][extremeAt & MASK]);
+                    double strength = isPositive ? combined : -combined;
+                    if (MINIMUM_THRESHOLD < strength)
+                    {
+                        candidates.push_back(Candidate{strength, q, extremeAt, 0, isPositive});
+                    }
+                }
+            }
+            previous1 = sensor1[k];
+            previous2 = sensor2[k];
+        }
+        cli.updateProgress("find_candidates", first + count);
+    }
+    cli.finishProgress("find_candidates");
+    return candidates;
+}
+
+bool GlobalDropFinder::update(const SampleBuffer &signal, Candidate &candidate)
+{
+    // Rows of the pair and of the NN pairs its sensor2 extreme is taken from
+    int64_t ticks[NN + 1];
+    double sensor1[NN + 1], sensor2[NN + 1];
+    size_t p = candidate.pair;
+    signal.read(p, NN + 1, ticks, sensor1, sensor2);
+
+    auto value = [&](const double *sensor, size_t i) -> double
+    {
+        if (used[p + i] || used[p + i + 1])
+            return 0;
+        return pairValue(sensor[i], sensor[i + 1], candidate.isPositive);
+    };
+
+    double extreme = value(sensor2, 0);
+    size_t extremeAt = p;
+    for (size_t i = 1; i < NN; i++)
+    {
+        double current = value(sensor2, i);
+        if (candidate.isPositive ? current > extreme : current < extreme)
+        {
+            extreme = current;
+            extremeAt = p + i;
+        }
+    }
+    double combined = candidate.isPositive ? std::min(value(sensor1, 0), extreme)
+                                           : std::max(value(sensor1, 0), extreme);
+
+    candidate.strength = candidate.isPositive ? combined : -combined;
+    candidate.extremeAt = extremeAt;
+    candidate.marks = marked;
+    return MINIMUM_THRESHOLD < candidate.strength;
+}
+
+Drop GlobalDropFinder::analyze(const SampleBuffer &signal, const Pick &pick)
+{
+    // Analyze the candidate on NN rows before it and DROP_SIZE from it
+    size_t start = pick.pair - NN;
+    signal.read(start, NN + DROP_SIZE, ticks.data(), sensor1.data(), sensor2.data());
+    for (size_t i = 0; i < NN + DROP_SIZE; i++)
+    {
+        rows.addSensorData(LVM::Row{ticks[i], sensor1[i], sensor2[i], 0});
+    }
+    Drop drop = dropFinder.analyzeDrop(
+        rows, Drop(pick.isPositive, NN, static_cast<int>(pick.extremeAt - start)));
+    if (drop.valid)
+    {
+        drop.dataOffset = static_cast<int>(start + drop.u1Original);
+    }
+    return drop;
+}
+
+size_t GlobalDropFinder::findDrops(const SampleBuffer &signal, CLI &cli,
+                                   const std::function<void(Drop &)> &onDrop)
+{
+    std::vector<Pick> picks;
+    std::vector<Candidate> heap = findCandidates(signal, cli);
+    size_t candidates = heap.size();
+    std::make_heap(heap.begin(), heap.end(), weaker);
+    used.assign(signal.size(), false);
+    marked = 0;
+
+    cli.startProgress("pick_drops", "Picking drops", candidates);
+    while (!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), weaker);
+        Candidate candidate = heap.back();
+        heap.pop_back();
+        cli.updateProgress("pick_drops", candidates - std::min(candidates, heap.size()));
+
+        // Rows marked since the candidate was computed may have weakened it
+        if (candidate.marks != marked && anyUsed(candidate.pair, candidate.pair + NN))
+        {
+            Candidate current = candidate;
+            if (!update(signal, current))
+                continue;
+            if (current.strength != candidate.strength ||
+                current.extremeAt != candidate.extremeAt)
+            {
+                heap.push_back(current);
+                std::push_heap(heap.begin(), heap.end(), weaker);
+                continue;
+            }
+        }
+
+        Pick pick{candidate.pair, candidate.extremeAt, 0, candidate.isPositive};
+        Drop drop = analyze(signal, pick);
+        if (!drop.valid)
+        {
+            // Failed validation - mark its peaks as used, as find_drops does
+            setUsed(candidate.pair, candidate.pair + 1);
+            setUsed(candidate.extremeAt, candidate.extremeAt + 1);
+            continue;
+        }
+        pick.first = drop.dataOffset;
+        setUsed(pick.first, pick.first + drop.size() - 1);
+        picks.push_back(pick);
+    }
+    cli.finishProgress("pick_drops");
+
+    // Analyze the picks again in time order, one drop at a time
+    std::stable_sort(picks.begin(), picks.end(),
+                     [](const Pick &a, const Pick &b) { return a.first < b.first; });
+    cli.startProgress("write_drops", "Writing drops", picks.size());
+    for (size_t i = 0; i < picks.size(); i++)
+    {
+        Drop drop = analyze(signal, picks[i]);
+        drop.id = static_cast<int>(i + 1);
+        onDrop(drop);
+        cli.updateProgress("write_drops", i + 1);
+    }
+    cli.finishProgress("write_drops");
+
+    std::ostringstream message;
+    message << "Picked " << picks.size() << " drops from " << candidates << " candidates";
+    cli.printStatus(message.str());
+    return picks.size();
+}
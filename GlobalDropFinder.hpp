@@ -0,0 +1,170 @@
+/**
+ * @file GlobalDropFinder.hpp
+ * @brief Header file for the GlobalDropFinder class - whole-signal drop search
+ *
+ * The windowed search of find_drops rebuilds the per-pair values of a
+ * window of 2*DROP_SIZE rows for every search, and picks the drops of each
+ * window strongest first. GlobalDropFinder makes a single pass over the
+ * whole normalized signal instead: it computes the same candidate value
+ * for every pair of rows (the sensor1 value of the pair against the
+ * extreme sensor2 value of the next NN pairs), then picks the drops of
+ * the whole signal strongest first, each picked drop excluding its rows
+ * from the candidates left.
+ */
+
+#pragma once
+
+#include "Drop.hpp"
+#include "DropFinder.hpp"
+#include "LVM.hpp"
+#include "SampleBuffer.hpp"
+#include "cli.hpp"
+#include "constants.hpp"
+#include "lib.hpp"
+
+/**
+ * @class GlobalDropFinder
+ * @brief Drop search over a whole normalized signal (drop_finder --engine=global)
+ *
+ * Pair p is made of rows p and p + 1, and its value for each sensor is the
+ * smaller (positive polarity) or larger (negative polarity) of the two, as
+ * in DropFinder; a pair with a NaN or infinite value is 0. The candidate of
+ * pair p combines its sensor1 value with the extreme sensor2 value of the
+ * pairs [p, p + NN), found with a monotonic queue as the pairs are read.
+ * Candidates stronger than MINIMUM_THRESHOLD are kept in a heap.
+ *
+ * Drops are then picked strongest first. Picking a drop marks its rows as
+ * used (or, for a candidate that fails the validation, the rows of its
+ * critical points, as find_drops does); a candidate whose rows then
+ * include used ones is recomputed without them and goes back to the heap
+ * if it is still strong enough. The values of a candidate can only fall
+ * when rows are marked, so each drop picked is the strongest of what is
+ * left.
+ *
+ * Only the picks are kept while picking (the rows of their critical
+ * points and their first row); they are then analyzed again in time order
+ * and handed out one at a time, so no more than one Drop is held in
+ * memory. On candidates of the same strength the later pair is picked
+ * first, as the backwards scan of DropFinder does. The drops still differ
+ * from those of the windowed search wherever a drop spans two of its
+ * windows or two candidates share rows across them.
+ */
+class GlobalDropFinder
+{
+public:
+    /**
+     * @brief Constructor for a whole-signal drop finder
+     * @param timeBase Time base of the data
+     */
+    explicit GlobalDropFinder(const TimeBase &timeBase = TimeBase());
+
+    /**
+     * @brief Finds the drops of a whole normalized signal
+     * @param signal Normalized signal
+     * @param cli Reference to CLI for progress reporting
+     * @param onDrop Called with each valid drop, in time order, with its id
+     *        and data offset set
+     * @return Number of drops found
+     */
+    size_t findDrops(const SampleBuffer &signal, CLI &cli,
+                     const std::function<void(Drop &)> &onDrop);
+
+private:
+    // Rows read from the signal at a time
+    static constexpr size_t BLOCK_ROWS = 1 << 16;
+
+    // Size of the rings of the candidate pass, a power of two above NN
+    static constexpr size_t CAPACITY = 256;
+    static constexpr size_t MASK = CAPACITY - 1;
+    static_assert(CAPACITY > NN, "GlobalDropFinder rings too small");
+
+    /**
+     * @struct Candidate
+     * @brief Drop candidate of one pair and polarity
+     */
+    struct Candidate
+    {
+        double strength;   // Absolute value of the candidate
+        size_t pair;       // Pair of the critical point of sensor1
+        size_t extremeAt;  // Pair of the critical point of sensor2
+        size_t marks;      // Rows marked as used when the candidate was computed
+        bool isPositive;   // Polarity of the candidate
+    };
+
+    /**
+     * @struct Pick
+     * @brief Candidate picked as a valid drop
+     */
+    struct Pick
+    {
+        size_t pair;       // Pair of the critical point of sensor1
+        size_t extremeAt;  // Pair of the critical point of sensor2
+        size_t first;      // First row of the drop
+        bool isPositive;   // Polarity of the drop
+    };
+
+    DropFinder dropFinder; // Analysis of the picked candidates
+    size_t marked;         // Times rows were marked as used
+    std::vector<bool> used; // Used rows of the signal
+
+    // Rows a pick is analyzed on, NN before its pair and DROP_SIZE from it
+    LVM rows;
+    std::vector<int64_t> ticks;
+    std::vector<double> sensor1, sensor2;
+
+    /**
+     * @brief Returns the value of a pair for one sensor
+     * @param first Value of the first row
+     * @param second Value of the second row
+     * @param isPositive Polarity of the value
+     */
+    static double pairValue(double first, double second, bool isPositive);
+
+    /**
+     * @brief Orders the candidates in the heap, the strongest one on top
+     *
+     * On ties the later pair comes first, and then the negative polarity
+     * (as DropFinder prefers them on ties).
+     *
+     * @return True if a is picked after b
+     */
+    static bool weaker(const Candidate &a, const Candidate &b);
+
+    /**
+     * @brief Computes the candidates of every pair of the signal
+     * @param signal Normalized signal
+     * @param cli Reference to CLI for progress reporting
+     * @return Candidates stronger than MINIMUM_THRESHOLD
+     */
+    std::vector<Candidate> findCandidates(const SampleBuffer &signal, CLI &cli);
+
+    /**
+     * @brief Recomputes a candidate without the used rows
+     * @param signal Normalized signal
+     * @param candidate Candidate to update
+     * @return False if it is no longer stronger than MINIMUM_THRESHOLD
+     */
+    bool update(const SampleBuffer &signal, Candidate &candidate);
+
+    /**
+     * @brief Analyzes the drop of a pick
+     * @param signal Normalized signal
+     * @param pick Pick to analyze
+     * @return Analyzed drop, with its data offset set if it is valid
+     */
+    Drop analyze(const SampleBuffer &signal, const Pick &pick);
+
+    /**
+     * @brief Checks whether any row of a range is used
+     * @param first First row
+     * @param last Last row (inclusive)
+     */
+    bool anyUsed(size_t first, size_t last) const;
+
+    /**
+     * @brief Marks a range of rows as used
+     * @param first First row
+     * @param last Last row (inclusive)
+     */
+    void setUsed(size_t first, size_t last);
+};
@@ -0,0 +1,80 @@
+/**
+ * @file HistogramMedian.cpp
+ * @brief Implementation of the HistogramMedian class
+ */
+
+#include "HistogramMedian.hpp"
+
+namespace {
+
+// Number of bins of the histogram
+constexpr size_t BINS = static_cast<size_t>(2 * HistogramMedian::RANGE / HistogramMedian::BIN_WIDTH);
+
+}
+
+HistogramMedian::HistogramMedian(size_t windowSize)
+    : windowSize(windowSize), pushed(0), bins(windowSize), counts(BINS), held(0), invalid(0),
+      medianBin(BINS / 2), below(0)
+{
+}
+
+void HistogramMedian::push(double value)
+{
+    size_t slot = pushed % windowSize;
+
+    // The oldest value leaves the window
+    if (pushed >= windowSize)
+    {
+        int32_t bin = bins[slot];
+        if (bin < 0)
+        {
+            invalid--;
+        }
+        else
+        {
+            counts[bin]--;
+            held--;
+            if (static_cast<size_t>(bin) < medianBin)
+                below--;
+        }
+    }
+    pushed++;
+
+    if (!std::isfinite(value))
+    {
+        bins[slot] = -1;
+        invalid++;
+        return;
+    }
+    double position = std::floor((value + RANGE) / BIN_WIDTH);
+    size_t bin = static_cast<size_t>(std::clamp(position, 0.0, static_cast<double>(BINS - 1)));
+    bins[slot] = static_cast<int32_t>(bin);
+    counts[bin]++;
+    held++;
+    if (bin < medianBin)
+        below++;
+}
+
+double HistogramMedian::median()
+{
+    if (invalid > 0 || held == 0)
+    {
+        return NAN;
+    }
+
+    // Walk to the bin holding the value of rank (held - 1) / 2
+    double rank = (held - 1) / 2.0;
+    while (below > rank)
+    {
+        medianBin--;
+        below -= counts[medianBin];
+    }
+    while (below + counts[medianBin] <= rank)
+    {
+        below += counts[medianBin];
+        medianBin++;
+    }
+
+    double offset = (rank - below + 0.5) / counts[medianBin];
+    return -RANGE + (medianBin + offset) * BIN_WIDTH;
+}
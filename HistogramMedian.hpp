@@ -0,0 +1,59 @@
+/**
+ * @file HistogramMedian.hpp
+ * @brief Header file for the HistogramMedian class - approximate sliding window median
+ *
+ * A cheaper alternative to RollingMedian: the window is kept as a
+ * histogram of quantized values, so adding and removing a value is O(1)
+ * and the median is found by walking from the bin it was in before, which
+ * is a few bins at most for a slowly drifting baseline.
+ */
+
+#pragma once
+
+#include "lib.hpp"
+
+/**
+ * @class HistogramMedian
+ * @brief Median of the last windowSize values, to within BIN_WIDTH
+ *
+ * Values are counted in bins of BIN_WIDTH volts between -RANGE and RANGE
+ * (values outside are counted in the first or last bin). The median is
+ * interpolated inside its bin as if the values of the bin were evenly
+ * spread, so its error is below BIN_WIDTH, far below MINIMUM_THRESHOLD.
+ */
+class HistogramMedian
+{
+public:
+    static constexpr double RANGE = 16;            // Largest value in a bin, in volts
+    static constexpr double BIN_WIDTH = 1.0 / 8192; // Width of a bin, in volts
+
+    /**
+     * @brief Constructor for an empty window
+     * @param windowSize Number of values in the window
+     */
+    explicit HistogramMedian(size_t windowSize);
+
+    /**
+     * @brief Adds the next value, dropping the oldest one once the window is full
+     * @param value Next value
+     */
+    void push(double value);
+
+    /**
+     * @brief Returns the approximate median of the values in the window
+     * @return Median (to within BIN_WIDTH for an odd number of values),
+     *         NaN if the window is empty or holds a NaN or
+     *         infinite value
+     */
+    double median();
+
+private:
+    size_t windowSize;             // Number of values in the window
+    size_t pushed;                 // Values pushed so far
+    std::vector<int32_t> bins;     // Bin of each value of the window (-1 if not finite), by index % windowSize
+    std::vector<uint32_t> counts;  // Values of the window in each bin
+    size_t held;                   // Finite values in the window
+    size_t invalid;                // NaN or infinite values in the window
+    size_t medianBin;              // Bin the median was in last time
+    size_t below;                  // Values of the window in the bins before medianBin
+};
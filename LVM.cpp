@@ -1,165 +1,132 @@
 #include "LVM.hpp"
 
-std::tuple<double, double, double> parse3d(const std::string &line)
+LVM::LVM(size_t buffer_size)
+    : totalUsed(0), head(0), count(0), maxSize(buffer_size)
 {
-    const char* ptr = line.data();
-    const char* end = ptr + line.size();
-    
-    // Skip leading whitespace
-    while (ptr < end && (*ptr == ' ' || *ptr == '\t')) ptr++;
-    
-    // Parse first double (time)
-    double time = 0.0;
-    bool negative = false;
-    if (ptr < end && *ptr == '-') {
-        negative = true;
-        ptr++;
-    }
-    
-    while (ptr < end && *ptr >= '0' && *ptr <= '9') {
-        time = time * 10.0 + (*ptr - '0');
-        ptr++;
-    }
-    
-    if (ptr < end && *ptr == '.') {
-        ptr++;
-        double fraction = 0.1;
-        while (ptr < end && *ptr >= '0' && *ptr <= '9') {
-            time += (*ptr - '0') * fraction;
-            fraction *= 0.1;
-            ptr++;
-        }
-    }
-    
-    if (negative) time = -time;
-    
-    // Skip whitespace
-    while (ptr < end && (*ptr == ' ' || *ptr == '\t')) ptr++;
-    
-    // Parse second double (sensor1)
-    double sensor1 = 0.0;
-    negative = false;
-    if (ptr < end && *ptr == '-') {
-        negative = true;
-        ptr++;
-    }
-    
-    while (ptr < end && *ptr >= '0' && *ptr <= '9') {
-        sensor1 = sensor1 * 10.0 + (*ptr - '0');
-        ptr++;
-    }
-    
-    if (ptr < end && *ptr == '.') {
-        ptr++;
-        double fraction = 0.1;
-        while (ptr < end && *ptr >= '0' && *ptr <= '9') {
-            sensor1 += (*ptr - '0') * fraction;
-            fraction *= 0.1;
-            ptr++;
-        }
-    }
-    
-    if (negative) sensor1 = -sensor1;
-    
-    // Skip whitespace
-    while (ptr < end && (*ptr == ' ' || *ptr == '\t')) ptr++;
-    
-    // Parse third double (sensor2)
-    double sensor2 = 0.0;
-    negative = false;
-    if (ptr < end && *ptr == '-') {
-        negative = true;
-        ptr++;
-    }
-    
-    while (ptr < end && *ptr >= '0' && *ptr <= '9') {
-        sensor2 = sensor2 * 10.0 + (*ptr - '0');
-        ptr++;
-    }
-    
-    if (ptr < end && *ptr == '.') {
-        ptr++;
-        double fraction = 0.1;
-        while (ptr < end && *ptr >= '0' && *ptr <= '9') {
-            sensor2 += (*ptr - '0') * fraction;
-            fraction *= 0.1;
-            ptr++;
-        }
-    }
-    
-    if (negative) sensor2 = -sensor2;
-    
-    return {time, sensor1, sensor2};
+    // Whole ring for bounded windows, grown on demand otherwise; at least
+    // one word of used flags
+    size_t capacity = 64;
+    while (capacity < std::min<size_t>(buffer_size, 1024))
+        capacity *= 2;
+    ticks.resize(capacity);
+    sensor1s.resize(capacity);
+    sensor2s.resize(capacity);
+    usedBits.resize(capacity / 64);
+    mask = capacity - 1;
 }
 
+void LVM::grow()
+{
+    size_t capacity = mask + 1;
+    std::vector<uint64_t> bits(2 * capacity / 64);
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t slot = (head + i) & mask;
+        bits[i >> 6] |= ((usedBits[slot >> 6] >> (slot & 63)) & 1) << (i & 63);
+    }
+    usedBits.swap(bits);
 
-LVM::LVM(size_t buffer_size) : totalUsed(0), maxSize(buffer_size) {}
+    // Unwrap the ring so the rows start at slot 0 again
+    std::rotate(ticks.begin(), ticks.begin() + head, ticks.end());
+    std::rotate(sensor1s.begin(), sensor1s.begin() + head, sensor1s.end());
+    std::rotate(sensor2s.begin(), sensor2s.begin() + head, sensor2s.end());
+    ticks.resize(2 * capacity);
+    sensor1s.resize(2 * capacity);
+    sensor2s.resize(2 * capacity);
+    head = 0;
+    mask = 2 * capacity - 1;
+}
 
-void LVM::addSensorData(const std::string &line)
+template <typename T>
+LVM::View<T> LVM::view(const std::vector<T> &column) const
 {
-    std::string modified_line = line;
-    std::replace(modified_line.begin(), modified_line.end(), ',', '.');
-    std::istringstream iss(modified_line);
-    double time, sensor1, sensor2;
-    if (!(iss >> time >> sensor1 >> sensor2))
+    size_t firstSize = std::min(count, mask + 1 - head);
+    return View<T>{column.data() + head, firstSize, column.data(), count};
+}
+
+void LVM::addSensorData(const Row &row)
+{
+    if (count == maxSize)
     {
-        throw std::invalid_argument("Invalid line format");
+        totalUsed -= (usedBits[head >> 6] >> (head & 63)) & 1;
+        head = (head + 1) & mask;
+        count--;
     }
-
-    if (data.size() == maxSize)
+    else if (count == mask + 1)
+    {
+        grow();
+    }
+    size_t slot = (head + count) & mask;
+    ticks[slot] = row.tick;
+    sensor1s[slot] = row.sensor1;
+    sensor2s[slot] = row.sensor2;
+    uint64_t bit = uint64_t(1) << (slot & 63);
+    usedBits[slot >> 6] &= ~bit;
+    count++;
+    if (row.used)
     {
-        if (data.front().used == 1)
-        {
-            totalUsed--;
-        }
-        data.pop_front(); // Remove the oldest element
+        setUsedSlots(slot, slot + 1);
     }
-    data.push_back({time, sensor1, sensor2, 0});
 }
 
-void LVM::addSensorData(Row &row)
+void LVM::setUsedSlots(size_t first, size_t last)
 {
-    if (data.size() == maxSize)
+    while (first < last)
     {
-        if (data.front().used == 1)
-        {
-            totalUsed--;
-        }
-        data.pop_front();
+        // Bits [first, end) of one word
+        size_t end = std::min(last, (first | 63) + 1);
+        size_t width = end - first;
+        uint64_t bits = (width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1)
+                        << (first & 63);
+        uint64_t &word = usedBits[first >> 6];
+        totalUsed += __builtin_popcountll(bits & ~word);
+        word |= bits;
+        first = end;
     }
-    data.push_back(row);
 }
 
 void LVM::setUsed(size_t r1, size_t r2)
 {
-    if (r2 >= data.size())
+    if (r2 >= count)
     {
         throw std::out_of_range("Index out of range");
     }
-    for (size_t i = r1; i <= r2; ++i)
+    if (r1 > r2)
     {
-        if (data.at(i).used == 0)
-        {
-            data.at(i).used = 1;
-            totalUsed++;
-        }
+        return;
     }
+    // The range covers at most two runs of slots (before and after the wrap)
+    size_t first = (head + r1) & mask;
+    size_t length = r2 - r1 + 1;
+    size_t firstLength = std::min(length, mask + 1 - first);
+    setUsedSlots(first, first + firstLength);
+    setUsedSlots(0, length - firstLength);
 }
 
-std::vector<LVM::Row> LVM::get() const
+size_t LVM::size() const { return count; }
+
+void LVM::clear()
 {
-    return std::vector<Row>(data.begin(), data.end());
+    head = 0;
+    count = 0;
+    totalUsed = 0;
 }
 
-size_t LVM::size() const { return data.size(); }
-
-void LVM::clear() { data.clear(); }
-
-LVM::Row &LVM::operator[](size_t index) { return data.at(index); }
+LVM::Row LVM::operator[](size_t index) const
+{
+    if (index >= count)
+    {
+        throw std::out_of_range("Index out of range");
+    }
+    size_t slot = (head + index) & mask;
+    return Row{ticks[slot], sensor1s[slot], sensor2s[slot], used()[index]};
+}
 
-LVM::Row LVM::operator[](size_t index) const { return data.at(index); }
+LVM::View<int64_t> LVM::tick() const { return view(ticks); }
+LVM::View<double> LVM::sensor1() const { return view(sensor1s); }
+LVM::View<double> LVM::sensor2() const { return view(sensor2s); }
 
-LVM::iterator LVM::begin() { return data.begin(); }
-LVM::iterator LVM::end() { return data.end(); }
-LVM::const_iterator LVM::begin() const { return data.begin(); }
-LVM::const_iterator LVM::end() const { return data.end(); }
+LVM::UsedBits LVM::used() const
+{
+    return UsedBits{usedBits.data(), head, mask, count};
+}
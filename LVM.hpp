@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "TimeBase.hpp"
 #include "lib.hpp"
 
 /**
@@ -20,12 +21,15 @@
  * processing sensor data streams. It provides:
  * - Efficient memory management with automatic overflow handling
  * - Tracking of used/unused data points for drop detection
- * - Iterator support for easy data access
+ * - In-place views of each column, without copying the rows
  * - Configurable buffer size for different processing stages
  * 
- * The class is optimized for the drop detection algorithm where
- * different processing stages require different buffer sizes and
- * data access patterns.
+ * The rows are stored column by column (tick, sensor1, sensor2 in separate
+ * arrays) in a ring whose capacity is a power of two, so a logical index
+ * maps to its slot with a mask. The rows of a column are contiguous except
+ * when the ring wraps around, which is why a column is seen through a View
+ * of at most two spans. The used flags are packed one bit per slot, so a
+ * range is marked (and counted with popcount) 64 rows at a time.
  */
 class LVM
 {
@@ -36,50 +40,114 @@ public:
      */
     struct Row
     {
-        double time;    // Timestamp of the measurement
+        int64_t tick;   // Time of the measurement, in sample ticks (see TimeBase)
         double sensor1; // Signal from ring sensor
         double sensor2; // Signal from dish sensor
         int used;       // Flag indicating if this point is already used in drop detection
     };
 
+    /**
+     * @struct View
+     * @brief Read-only view of one column, oldest row first
+     *
+     * The rows are first[0 .. firstSize) followed by second[0 .. size -
+     * firstSize); second is only used when the ring wraps around. The view
+     * is valid until the buffer is modified.
+     */
+    template <typename T>
+    struct View
+    {
+        const T *first;   // Oldest rows, up to the end of the ring
+        size_t firstSize; // Number of rows in first
+        const T *second;  // Remaining rows, from the start of the ring
+        size_t count;     // Total number of rows
+
+        const T &operator[](size_t index) const
+        {
+            return index < firstSize ? first[index] : second[index - firstSize];
+        }
+
+        size_t size() const { return count; }
+    };
+
+    /**
+     * @struct UsedBits
+     * @brief Read-only view of the used flags, oldest row first
+     *
+     * Bit (slot % 64) of words[slot / 64] is the flag of the row in that
+     * slot. The view is valid until the buffer is modified.
+     */
+    struct UsedBits
+    {
+        const uint64_t *words; // Packed flags, by slot
+        size_t head;           // Slot of the oldest row
+        size_t mask;           // Capacity - 1
+        size_t count;          // Total number of rows
+
+        bool operator[](size_t index) const
+        {
+            size_t slot = (head + index) & mask;
+            return (words[slot >> 6] >> (slot & 63)) & 1;
+        }
+
+        size_t size() const { return count; }
+    };
+
     size_t totalUsed; // Total count of used data points
 
 private:
-    std::deque<Row> data; // Circular buffer storing the sensor data
-    size_t maxSize;       // Maximum size of the buffer (0 = unlimited)
+    std::vector<int64_t> ticks;   // Times in sample ticks, by slot
+    std::vector<double> sensor1s; // Ring sensor signal, by slot
+    std::vector<double> sensor2s; // Dish sensor signal, by slot
+    std::vector<uint64_t> usedBits; // Used flags, one bit per slot
+    size_t head;                  // Slot of the oldest row
+    size_t count;                 // Number of rows stored
+    size_t mask;                  // Capacity - 1 (capacity is a power of two)
+    size_t maxSize;               // Maximum size of the buffer (size_t(-1) = unlimited)
 
-public:
     /**
-     * @brief Constructor for LVM buffer
-     * @param buffer_size Maximum size of the buffer (0 for unlimited)
+     * @brief Doubles the capacity, keeping the rows in order
      */
-    LVM(size_t buffer_size);
+    void grow();
 
     /**
-     * @brief Adds sensor data from a string line
-     * @param line String containing time, sensor1, sensor2 values
+     * @brief Sets the used flags of a range of slots that does not wrap
+     * @param first First slot
+     * @param last Slot after the last one
      */
-    void addSensorData(const std::string &line);
+    void setUsedSlots(size_t first, size_t last);
+
+    /**
+     * @brief Returns the view of one column
+     * @param column Array of the column, by slot
+     */
+    template <typename T>
+    View<T> view(const std::vector<T> &column) const;
+
+public:
+    /**
+     * @brief Constructor for LVM buffer
+     * @param buffer_size Maximum size of the buffer (size_t(-1) for unlimited)
+     */
+    LVM(size_t buffer_size);
 
     /**
      * @brief Adds sensor data from a Row object
+     *
+     * When the buffer is full the oldest row is dropped.
+     *
      * @param row Row object containing the sensor data
      */
-    void addSensorData(Row &row);
+    void addSensorData(const Row &row);
     
     /**
      * @brief Marks a range of data points as used
      * @param r1 Start index of the range
      * @param r2 End index of the range (inclusive)
+     * @throws std::out_of_range if r2 is past the last row
      */
     void setUsed(size_t r1, size_t r2);
 
-    /**
-     * @brief Returns a copy of all data as a vector
-     * @return Vector containing all data points
-     */
-    std::vector<Row> get() const;
-
     /**
      * @brief Returns the current size of the buffer
      * @return Number of data points currently stored
@@ -91,26 +159,19 @@ public:
      */
     void clear();
 
-    /**
-     * @brief Access operator for reading/writing data points
-     * @param index Index of the data point
-     * @return Reference to the Row at the specified index
-     */
-    Row &operator[](size_t index);
-
     /**
      * @brief Access operator for reading data points
-     * @param index Index of the data point
+     * @param index Index of the data point (0 is the oldest)
      * @return Copy of the Row at the specified index
+     * @throws std::out_of_range if index is past the last row
      */
     Row operator[](size_t index) const;
 
-    // Iterator support for range-based loops
-    using iterator = std::deque<Row>::iterator;
-    using const_iterator = std::deque<Row>::const_iterator;
-
-    iterator begin();
-    iterator end();
-    const_iterator begin() const;
-    const_iterator end() const;
+    /**
+     * @brief Views of the columns, valid until the buffer is modified
+     */
+    View<int64_t> tick() const;
+    View<double> sensor1() const;
+    View<double> sensor2() const;
+    UsedBits used() const;
 };
@@ -0,0 +1,154 @@
+/**
+ * @file LVMHeader.cpp
+ * @brief Implementation of the LVMHeader class
+ */
+
+#include "LVMHeader.hpp"
+#include "file.hpp"
+#include "scanner.hpp"
+
+namespace {
+
+constexpr std::string_view MAGIC = "LabVIEW Measurement";
+constexpr std::string_view END_OF_HEADER = "***End_of_Header***";
+
+/**
+ * @brief Splits a header line on tabs, dropping trailing empty fields
+ */
+std::vector<std::string_view> splitTabs(std::string_view line)
+{
+    std::vector<std::string_view> fields;
+    size_t start = 0;
+    while (start <= line.size())
+    {
+        size_t tab = std::min(line.find('\t', start), line.size());
+        fields.push_back(line.substr(start, tab - start));
+        start = tab + 1;
+    }
+    while (!fields.empty() && fields.back().empty())
+    {
+        fields.pop_back();
+    }
+    return fields;
+}
+
+/**
+ * @brief Checks whether a line starts with a number (a sample line)
+ */
+bool startsWithNumber(std::string_view line)
+{
+    size_t first = line.find_first_not_of(" \t");
+    if (first == std::string_view::npos)
+        return false;
+    char c = line[first];
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+           c == ',';
+}
+
+}
+
+LVMHeader LVMHeader::parse(std::string_view contents)
+{
+    LVMHeader header;
+    if (contents.substr(0, MAGIC.size()) != MAGIC)
+    {
+        return header;
+    }
+
+    double deltaX = 0;
+    bool pastHeader = false;
+    size_t position = 0, lineStart = 0;
+    std::string_view line;
+    while (lineStart = position, nextLine(contents, position, line))
+    {
+        if (pastHeader && startsWithNumber(line))
+            break;
+        header.lineCount++;
+
+        std::vector<std::string_view> fields = splitTabs(line);
+        if (fields.empty())
+            continue;
+        std::string_view key = fields[0];
+
+        if (key == END_OF_HEADER)
+        {
+            pastHeader = true;
+        }
+        else if (key == "Separator" && fields.size() > 1 && fields[1] != "Tab")
+        {
+            throw std::invalid_argument("Unsupported LVM separator: " +
+                                        std::string(fields[1]));
+        }
+        else if (key == "X_Columns" && fields.size() > 1 && fields[1] != "One")
+        {
+            throw std::invalid_argument("Unsupported LVM X_Columns: " +
+                                        std::string(fields[1]));
+        }
+        else if (key == "Date" && header.date.empty() && fields.size() > 1)
+        {
+            header.date = fields[1];
+        }
+        else if (key == "Time" && header.time.empty() && fields.size() > 1)
+        {
+            header.time = fields[1];
+        }
+        else if (key == "Delta_X")
+        {
+            // One value per channel, all channels must share the clock
+            for (size_t i = 1; i < fields.size(); i++)
+            {
+                double value;
+                if (fields[i].empty())
+                    continue;
+                if (!scanner::parseDecimal(fields[i], value) || !(value > 0) ||
+                    (deltaX != 0 && std::abs(value - deltaX) > 1e-9 * deltaX))
+                {
+                    throw std::invalid_argument("Invalid LVM Delta_X: " +
+                                                std::string(fields[i]));
+                }
+                deltaX = value;
+            }
+        }
+        else if (key == "X_Value")
+        {
+            header.channelNames.clear();
+            for (size_t i = 1; i < fields.size(); i++)
+            {
+                if (fields[i] != "Comment")
+                    header.channelNames.emplace_back(fields[i]);
+            }
+        }
+    }
+    header.dataOffset = lineStart;
+
+    if (deltaX > 0)
+    {
+        // Delta_X is written with a few digits: snap to a whole rate
+        double rate = 1 / deltaX;
+        header.dataPerSecond =
+            std::abs(rate - std::round(rate)) < 1e-6 * rate ? std::round(rate)
+                                                            : rate;
+    }
+    return header;
+}
+
+bool LVMHeader::present() const { return lineCount > 0; }
+
+std::string LVMHeader::startTimestamp() const
+{
+    if (date.empty() || time.empty())
+        return date + time;
+    return date + " " + time;
+}
+
+std::string LVMHeader::channelName(size_t sensor) const
+{
+    if (sensor < channelNames.size())
+        return channelNames[sensor];
+    return "sensor" + std::to_string(sensor + 1);
+}
+
+TimeBase LVMHeader::timeBase() const
+{
+    return TimeBase(dataPerSecond, timeOrigin);
+}
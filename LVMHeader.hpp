@@ -0,0 +1,72 @@
+/**
+ * @file LVMHeader.hpp
+ * @brief Header file for the LVMHeader class - LabVIEW measurement file header
+ *
+ * Files saved by LabVIEW start with a text header (file header, segment
+ * header and a row with the channel names) before the samples. This class
+ * reads that block in place from the mapped file, so the acquisition
+ * settings come from the file itself and the samples can be parsed right
+ * after it without stripping the header beforehand.
+ */
+
+#pragma once
+
+#include "TimeBase.hpp"
+#include "constants.hpp"
+#include "lib.hpp"
+
+/**
+ * @class LVMHeader
+ * @brief Acquisition settings read from the header of an .lvm file
+ *
+ * Files without a header (plain columns of numbers) get the defaults:
+ * DATA_PER_SECOND samples per second, no start timestamp and no channel
+ * names. Only the first segment header is read; the data must be a single
+ * segment with one time column (X_Columns "One") separated by tabs.
+ */
+class LVMHeader
+{
+public:
+    double dataPerSecond = DATA_PER_SECOND; // Sample rate (1 / Delta_X)
+    std::string date;                       // Acquisition start date, as written by LabVIEW
+    std::string time;                       // Acquisition start time, as written by LabVIEW
+    std::vector<std::string> channelNames;  // Names of the sensor columns, in file order
+    size_t dataOffset = 0;                  // Offset of the first sample line
+    size_t lineCount = 0;                   // Lines before the first sample line
+    double timeOrigin = 0;                  // Time of the first sample read (set by the reader)
+
+    /**
+     * @brief Reads the header at the start of a buffer
+     *
+     * Only the header lines are touched; parsing stops at the first line
+     * that starts with a number.
+     *
+     * @param contents Contents of the .lvm file
+     * @return Parsed header (defaults if the file has no header)
+     * @throws std::invalid_argument if the header describes a layout that
+     *         cannot be read (other separator, several time columns,
+     *         inconsistent or invalid Delta_X)
+     */
+    static LVMHeader parse(std::string_view contents);
+
+    /**
+     * @brief Checks whether the file had a LabVIEW header
+     */
+    bool present() const;
+
+    /**
+     * @brief Returns "date time" of the acquisition start (empty if unknown)
+     */
+    std::string startTimestamp() const;
+
+    /**
+     * @brief Returns the name of a sensor column, or "sensor<n>" if unknown
+     * @param sensor 0-based sensor column (time excluded)
+     */
+    std::string channelName(size_t sensor) const;
+
+    /**
+     * @brief Returns the time base of the samples (sample rate and origin)
+     */
+    TimeBase timeBase() const;
+};
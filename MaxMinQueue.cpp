@@ -9,6 +9,20 @@
 
 #include "MaxMinQueue.hpp"
 
+MaxMinQueue::MaxMinQueue(size_t capacity)
+{
+    queue.entries.resize(capacity);
+    maxDeque.entries.resize(capacity);
+    minDeque.entries.resize(capacity);
+}
+
+void MaxMinQueue::clear()
+{
+    queue.head = queue.tail = 0;
+    maxDeque.head = maxDeque.tail = 0;
+    minDeque.head = minDeque.tail = 0;
+}
+
 /**
  * @brief Add a new value to the queue
  * 
@@ -24,18 +24,61 @@
  * The data structure is optimized for the drop detection algorithm
  * where we need to find the best (min/max) sensor values within
  * a sliding window of fixed size.
+ * 
+ * The deques are arrays allocated once, at construction, for the number
+ * of values pushed between two calls to clear(): none of them ever holds
+ * more entries than that, so they never wrap around nor grow, and the
+ * queue can be reused for every search without allocating.
  */
 class MaxMinQueue
 {
 private:
-    std::deque<std::pair<double, int>> queue; // Main queue storing (value, index) pairs
-    std::deque<std::pair<std::pair<double, int>, int>> maxDeque; // Deque for tracking maximum values
-    std::deque<std::pair<std::pair<double, int>, int>> minDeque; // Deque for tracking minimum values
+    /**
+     * @struct Deque
+     * @brief Fixed array used as a deque, entries [head, tail)
+     */
+    template <typename T>
+    struct Deque
+    {
+        std::vector<T> entries; // Storage, one entry per value pushed since clear()
+        size_t head = 0;        // Position of the front entry
+        size_t tail = 0;        // Position after the back entry
+
+        bool empty() const { return head == tail; }
+        size_t size() const { return tail - head; }
+        T &front() { return entries[head]; }
+        const T &front() const { return entries[head]; }
+        T &back() { return entries[tail - 1]; }
+        void pop_front() { head++; }
+        void pop_back() { tail--; }
+        void push_back(const T &entry)
+        {
+            if (tail == entries.size())
+                throw std::length_error("Queue is full");
+            entries[tail++] = entry;
+        }
+    };
+
+    Deque<std::pair<double, int>> queue; // Main queue storing (value, index) pairs
+    Deque<std::pair<std::pair<double, int>, int>> maxDeque; // Deque for tracking maximum values
+    Deque<std::pair<std::pair<double, int>, int>> minDeque; // Deque for tracking minimum values
 
 public:
+    /**
+     * @brief Constructor for an empty queue
+     * @param capacity Values that can be pushed between two calls to clear()
+     */
+    explicit MaxMinQueue(size_t capacity);
+
+    /**
+     * @brief Removes every value, keeping the storage
+     */
+    void clear();
+
     /**
      * @brief Add a new value to the queue
      * @param value Pair of (value, index) to add
+     * @throws std::length_error if capacity values were pushed since clear()
      */
     void push(std::pair<double, int> value);
 
@@ -0,0 +1,127 @@
+/**
+ * @file RollingMedian.cpp
+ * @brief Implementation of the RollingMedian class
+ */
+
+#include "RollingMedian.hpp"
+
+RollingMedian::RollingMedian(size_t windowSize)
+    : windowSize(windowSize), pushed(0), values(windowSize), inLower(windowSize),
+      lowerCount(0), upperCount(0), invalid(0)
+{
+    lower.reserve(2 * windowSize);
+    upper.reserve(2 * windowSize);
+}
+
+bool RollingMedian::lowerOrder(const Entry &a, const Entry &b)
+{
+    // The index only breaks ties, so that the order is strict
+    return a.value < b.value || (a.value == b.value && a.index < b.index);
+}
+
+bool RollingMedian::upperOrder(const Entry &a, const Entry &b)
+{
+    return lowerOrder(b, a);
+}
+
+bool RollingMedian::isStale(const Entry &entry) const
+{
+    return entry.index + windowSize < pushed;
+}
+
+void RollingMedian::prune(bool toLower)
+{
+    std::vector<Entry> &heap = toLower ? lower : upper;
+    auto order = toLower ? lowerOrder : upperOrder;
+    while (!heap.empty() && isStale(heap.front()))
+    {
+        std::pop_heap(heap.begin(), heap.end(), order);
+        heap.pop_back();
+    }
+}
+
+void RollingMedian::insert(const Entry &entry, bool toLower)
+{
+    std::vector<Entry> &heap = toLower ? lower : upper;
+    auto order = toLower ? lowerOrder : upperOrder;
+    size_t &count = toLower ? lowerCount : upperCount;
+
+    // Too many stale entries buried in the heap: rebuild it without them
+    if (heap.size() >= 2 * count + 64)
+    {
+        heap.erase(std::remove_if(heap.begin(), heap.end(),
+                                  [this](const Entry &e) { return isStale(e); }),
+                   heap.end());
+        std::make_heap(heap.begin(), heap.end(), order);
+    }
+    heap.push_back(entry);
+    std::push_heap(heap.begin(), heap.end(), order);
+    inLower[entry.index % windowSize] = toLower;
+    count++;
+}
+
+void RollingMedian::move(bool fromLower)
+{
+    std::vector<Entry> &heap = fromLower ? lower : upper;
+    prune(fromLower);
+    Entry top = heap.front();
+    std::pop_heap(heap.begin(), heap.end(), fromLower ? lowerOrder : upperOrder);
+    heap.pop_back();
+    (fromLower ? lowerCount : upperCount)--;
+    insert(top, !fromLower);
+}
+
+void RollingMedian::push(double value)
+{
+    size_t slot = pushed % windowSize;
+
+    // The oldest value leaves the window; its entry is dropped later
+    if (pushed >= windowSize)
+    {
+        if (!std::isfinite(values[slot]))
+            invalid--;
+        else if (inLower[slot])
+            lowerCount--;
+        else
+            upperCount--;
+    }
+    values[slot] = value;
+    Entry entry{value, pushed};
+    pushed++;
+
+    if (!std::isfinite(value))
+    {
+        invalid++;
+    }
+    else
+    {
+        // Any value up to the smallest of the upper half can go to the lower one
+        prune(false);
+        insert(entry, upperCount == 0 || value <= upper.front().value);
+    }
+
+    // Keep the lower half one value larger at most
+    while (lowerCount > upperCount + 1)
+    {
+        move(true);
+    }
+    while (upperCount > lowerCount)
+    {
+        move(false);
+    }
+}
+
+double RollingMedian::median()
+{
+    if (invalid > 0 || lowerCount == 0)
+    {
+        return NAN;
+    }
+    prune(true);
+    if (lowerCount > upperCount)
+    {
+        return lower.front().value;
+    }
+    prune(false);
+    return (lower.front().value + upper.front().value) / 2;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file RollingMedian.hpp
+ * @brief Header file for the RollingMedian class - exact sliding window median
+ *
+ * During heavy rain the drops themselves pull the rolling mean used as
+ * baseline by the normalizer. The median of the same window is not moved
+ * by a few large values, so it can be used as a more robust baseline.
+ */
+
+#pragma once
+
+#include "lib.hpp"
+
+/**
+ * @class RollingMedian
+ * @brief Exact median of the last windowSize values, O(log windowSize) per value
+ *
+ * The window is split in two heaps: a max-heap with the lower half and a
+ * min-heap with the upper half, so the median is on top of the lower
+ * half. Values leaving the window are not searched for: they are only
+ * counted out of their heap, and dropped when they reach its top (or when
+ * a heap holds as many stale entries as live ones, by rebuilding it), so
+ * the heaps stay bounded by a few windows.
+ */
+class RollingMedian
+{
+public:
+    /**
+     * @brief Constructor for an empty window
+     * @param windowSize Number of values in the window
+     */
+    explicit RollingMedian(size_t windowSize);
+
+    /**
+     * @brief Adds the next value, dropping the oldest one once the window is full
+     * @param value Next value
+     */
+    void push(double value);
+
+    /**
+     * @brief Returns the median of the values in the window
+     * @return Median (mean of the two middle values for an even count),
+     *         NaN if the window is empty or holds a NaN or infinite value
+     */
+    double median();
+
+private:
+    /**
+     * @struct Entry
+     * @brief A value in one of the heaps
+     */
+    struct Entry
+    {
+        double value; // Value
+        size_t index; // Number of values pushed before it
+    };
+
+    size_t windowSize;          // Number of values in the window
+    size_t pushed;              // Values pushed so far
+    std::vector<double> values; // Values of the window, by index % windowSize
+    std::vector<char> inLower;  // Whether each value is in lower, by index % windowSize
+    std::vector<Entry> lower;   // Max-heap with the lower half (and stale entries)
+    std::vector<Entry> upper;   // Min-heap with the upper half (and stale entries)
+    size_t lowerCount;          // Values of the window in lower
+    size_t upperCount;          // Values of the window in upper
+    size_t invalid;             // NaN or infinite values in the window
+
+    /**
+     * @brief Heap order of lower (the largest value on top)
+     */
+    static bool lowerOrder(const Entry &a, const Entry &b);
+
+    /**
+     * @brief Heap order of upper (the smallest value on top)
+     */
+    static bool upperOrder(const Entry &a, const Entry &b);
+
+    /**
+     * @brief Checks whether an entry left the window
+     */
+    bool isStale(const Entry &entry) const;
+
+    /**
+     * @brief Drops the stale entries from the top of a heap
+     * @param toLower True for lower, false for upper
+     */
+    void prune(bool toLower);
+
+    /**
+     * @brief Adds a value of the window to a heap
+     * @param entry Value to add
+     * @param toLower True for lower, false for upper
+     */
+    void insert(const Entry &entry, bool toLower);
+
+    /**
+     * @brief Moves the top value of a heap to the other one
+     * @param fromLower True to move from lower to upper
+     */
+    void move(bool fromLower);
+};
@@ -0,0 +1,219 @@
+/**
+ * @file SampleBuffer.cpp
+ * @brief Implementation of the SampleBuffer class
+ */
+
+#include "SampleBuffer.hpp"
+
+SampleBuffer::Precision SampleBuffer::defaultPrecision()
+{
+#ifdef FLOAT_SAMPLES
+    return Precision::Float;
+#else
+    return Precision::Double;
+#endif
+}
+
+SampleBuffer::Precision SampleBuffer::parsePrecision(const std::string &name)
+{
+    if (name == "double")
+        return Precision::Double;
+    if (name == "float")
+        return Precision::Float;
+    throw std::invalid_argument("Unknown sample precision: " + name);
+}
+
+const char *SampleBuffer::precisionName(Precision precision)
+{
+    return precision == Precision::Float ? "float" : "double";
+}
+
+SampleBuffer::SampleBuffer(Precision precision)
+    : storage(precision), rows(0), nextTick(0)
+{
+}
+
+SampleBuffer::SampleBuffer(Precision precision, const std::string &scratchDirectory,
+                           size_t ramBudget)
+    : SampleBuffer(precision)
+{
+    size_t recordSize = precision == Precision::Float ? 2 * sizeof(float) : 2 * sizeof(double);
+    scratch = std::make_unique<ScratchFile>(scratchDirectory, ramBudget, recordSize);
+}
+
+void SampleBuffer::push(const LVM::Row &row)
+{
+    if (runs.empty() || row.tick != nextTick)
+    {
+        runs.push_back(Run{rows, row.tick});
+    }
+    nextTick = row.tick + 1;
+
+    if (scratch && storage == Precision::Float)
+    {
+        float *sensors = reinterpret_cast<float *>(scratch->append());
+        sensors[0] = static_cast<float>(row.sensor1);
+        sensors[1] = static_cast<float>(row.sensor2);
+    }
+    else if (scratch)
+    {
+        double *sensors = reinterpret_cast<double *>(scratch->append());
+        sensors[0] = row.sensor1;
+        sensors[1] = row.sensor2;
+    }
+    else if (storage == Precision::Float)
+    {
+        sensor1Float.push_back(static_cast<float>(row.sensor1));
+        sensor2Float.push_back(static_cast<float>(row.sensor2));
+    }
+    else
+    {
+        sensor1Double.push_back(row.sensor1);
+        sensor2Double.push_back(row.sensor2);
+    }
+    rows++;
+}
+
+void SampleBuffer::reserve(size_t capacity)
+{
+    if (scratch)
+        return;
+    if (storage == Precision::Float)
+    {
+        sensor1Float.reserve(capacity);
+        sensor2Float.reserve(capacity);
+    }
+    else
+    {
+        sensor1Double.reserve(capacity);
+        sensor2Double.reserve(capacity);
+    }
+}
+
+void SampleBuffer::append(const int64_t *ticks, const double *sensor1, const double *sensor2,
+                          size_t count)
+{
+    if (scratch)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            push(LVM::Row{ticks[i], sensor1[i], sensor2[i], 0});
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (runs.empty() || ticks[i] != nextTick)
+        {
+            runs.push_back(Run{rows + i, ticks[i]});
+        }
+        nextTick = ticks[i] + 1;
+    }
+    if (storage == Precision::Float)
+    {
+        sensor1Float.insert(sensor1Float.end(), sensor1, sensor1 + count);
+        sensor2Float.insert(sensor2Float.end(), sensor2, sensor2 + count);
+    }
+    else
+    {
+        sensor1Double.insert(sensor1Double.end(), sensor1, sensor1 + count);
+        sensor2Double.insert(sensor2Double.end(), sensor2, sensor2 + count);
+    }
+    rows += count;
+}
+
+void SampleBuffer::read(size_t first, size_t count, int64_t *ticks, double *sensor1,
+                        double *sensor2) const
+{
+    if (count == 0)
+        return;
+
+    // Walk the runs from the one holding the first row
+    auto run = std::upper_bound(runs.begin(), runs.end(), first,
+                                [](size_t i, const Run &r) { return i < r.index; }) - 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t index = first + i;
+        if (run + 1 != runs.end() && (run + 1)->index == index)
+        {
+            run++;
+        }
+        ticks[i] = run->tick + static_cast<int64_t>(index - run->index);
+    }
+
+    if (scratch)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            LVM::Row row = (*this)[first + i];
+            sensor1[i] = row.sensor1;
+            sensor2[i] = row.sensor2;
+        }
+    }
+    else if (storage == Precision::Float)
+    {
+        std::copy_n(sensor1Float.begin() + first, count, sensor1);
+        std::copy_n(sensor2Float.begin() + first, count, sensor2);
+    }
+    else
+    {
+        std::copy_n(sensor1Double.begin() + first, count, sensor1);
+        std::copy_n(sensor2Double.begin() + first, count, sensor2);
+    }
+}
+
+int64_t SampleBuffer::tick(size_t index) const
+{
+    // Last run starting at or before the row
+    auto run = std::upper_bound(runs.begin(), runs.end(), index,
+                                [](size_t i, const Run &r) { return i < r.index; }) - 1;
+    return run->tick + static_cast<int64_t>(index - run->index);
+}
+
+LVM::Row SampleBuffer::operator[](size_t index) const
+{
+    if (scratch && storage == Precision::Float)
+    {
+        const float *sensors = reinterpret_cast<const float *>((*scratch)[index]);
+        return LVM::Row{tick(index), sensors[0], sensors[1], 0};
+    }
+    if (scratch)
+    {
+        const double *sensors = reinterpret_cast<const double *>((*scratch)[index]);
+        return LVM::Row{tick(index), sensors[0], sensors[1], 0};
+    }
+    if (storage == Precision::Float)
+    {
+        return LVM::Row{tick(index), sensor1Float[index], sensor2Float[index], 0};
+    }
+    return LVM::Row{tick(index), sensor1Double[index], sensor2Double[index], 0};
+}
+
+size_t SampleBuffer::size() const { return rows; }
+
+void SampleBuffer::clear()
+{
+    rows = 0;
+    std::vector<Run>().swap(runs);
+    std::vector<double>().swap(sensor1Double);
+    std::vector<double>().swap(sensor2Double);
+    std::vector<float>().swap(sensor1Float);
+    std::vector<float>().swap(sensor2Float);
+    if (scratch)
+    {
+        scratch->clear();
+    }
+}
+
+size_t SampleBuffer::bytes() const
+{
+    return runs.capacity() * sizeof(Run) +
+           (sensor1Double.capacity() + sensor2Double.capacity()) * sizeof(double) +
+           (sensor1Float.capacity() + sensor2Float.capacity()) * sizeof(float) +
+           (scratch ? std::min(scratch->bytes(), scratch->budget()) : 0);
+}
+
+size_t SampleBuffer::scratchBytes() const { return scratch ? scratch->bytes() : 0; }
+
+SampleBuffer::Precision SampleBuffer::precision() const { return storage; }
@@ -0,0 +1,173 @@
+/**
+ * @file SampleBuffer.hpp
+ * @brief Header file for the SampleBuffer class - compact whole-signal storage
+ *
+ * drop_finder keeps whole signals in memory between the read, fill and
+ * normalize steps. Stored as LVM::Row (three doubles and an int, padded to
+ * 32 bytes) a 20M sample storm takes 640 MB per copy. SampleBuffer stores
+ * the same rows in 16 bytes (double sensors) or 8 bytes (float sensors)
+ * per sample: the tick is implied by the row index, and only the
+ * places where the ticks are not consecutive are stored.
+ */
+
+#pragma once
+
+#include "LVM.hpp"
+#include "ScratchFile.hpp"
+#include "constants.hpp"
+#include "lib.hpp"
+
+/**
+ * @class SampleBuffer
+ * @brief Append-only signal of one sensor pair, stored column by column
+ *
+ * A run table holds the first row and the tick of every stretch of rows
+ * with consecutive ticks, so a signal without gaps (or one whose gaps
+ * were filled) takes a single entry.
+ *
+ * Sensors are stored as double or, with Precision::Float, rounded to
+ * float, either in memory or, out of core, in a ScratchFile with a bounded
+ * resident size. The used flag of the rows is not stored: it only matters
+ * in the drop search window, which is an LVM.
+ */
+class SampleBuffer
+{
+public:
+    /**
+     * @brief Storage type of the sensor values
+     */
+    enum class Precision
+    {
+        Double,
+        Float
+    };
+
+    /**
+     * @brief Precision used when none is given on the command line
+     *
+     * Float when built with -DFLOAT_SAMPLES (make SAMPLES=float).
+     */
+    static Precision defaultPrecision();
+
+    /**
+     * @brief Parses a precision name as accepted on the command line
+     * @param name "double" or "float"
+     * @return Matching precision
+     * @throws std::invalid_argument if the name is unknown
+     */
+    static Precision parsePrecision(const std::string &name);
+
+    /**
+     * @brief Returns a printable name for a precision
+     * @param precision Precision to name
+     * @return "double" or "float"
+     */
+    static const char *precisionName(Precision precision);
+
+    /**
+     * @brief Constructor for an empty buffer
+     * @param precision Storage type of the sensor values
+     */
+    explicit SampleBuffer(Precision precision = defaultPrecision());
+
+    /**
+     * @brief Constructor for an empty buffer stored out of core
+     * @param precision Storage type of the sensor values
+     * @param scratchDirectory Directory of the scratch file of the sensors
+     * @param ramBudget Bytes of sensor values allowed to stay in RAM
+     * @throws std::runtime_error if the scratch file cannot be created
+     */
+    SampleBuffer(Precision precision, const std::string &scratchDirectory, size_t ramBudget);
+
+    /**
+     * @brief Appends a row at the end of the signal
+     * @param row Row to append (the used flag is ignored)
+     */
+    void push(const LVM::Row &row);
+
+    /**
+     * @brief Allocates room for a number of rows (in memory only)
+     * @param capacity Total number of rows expected
+     */
+    void reserve(size_t capacity);
+
+    /**
+     * @brief Appends rows given column by column
+     * @param ticks Ticks of the rows
+     * @param sensor1 sensor1 of the rows
+     * @param sensor2 sensor2 of the rows
+     * @param count Number of rows
+     */
+    void append(const int64_t *ticks, const double *sensor1, const double *sensor2,
+                size_t count);
+
+    /**
+     * @brief Copies consecutive rows column by column
+     * @param first Index of the first row
+     * @param count Number of rows
+     * @param ticks Output ticks, count values
+     * @param sensor1 Output sensor1, count values
+     * @param sensor2 Output sensor2, count values
+     */
+    void read(size_t first, size_t count, int64_t *ticks, double *sensor1,
+              double *sensor2) const;
+
+    /**
+     * @brief Returns a row of the signal
+     * @param index Index of the row
+     * @return Copy of the row (used flag 0)
+     */
+    LVM::Row operator[](size_t index) const;
+
+    /**
+     * @brief Returns the tick of a row
+     * @param index Index of the row
+     */
+    int64_t tick(size_t index) const;
+
+    /**
+     * @brief Returns the number of rows stored
+     */
+    size_t size() const;
+
+    /**
+     * @brief Removes all rows and releases their memory
+     */
+    void clear();
+
+    /**
+     * @brief Returns the memory used by the stored rows, in bytes
+     *
+     * Out of core, the sensor values count for the RAM budget at most.
+     */
+    size_t bytes() const;
+
+    /**
+     * @brief Returns the size of the scratch file, in bytes (0 in memory)
+     */
+    size_t scratchBytes() const;
+
+    /**
+     * @brief Returns the storage type of the sensor values
+     */
+    Precision precision() const;
+
+private:
+    /**
+     * @struct Run
+     * @brief Stretch of rows with consecutive ticks
+     */
+    struct Run
+    {
+        size_t index; // First row of the run
+        int64_t tick; // Tick of that row
+    };
+
+    Precision storage;                               // Storage type of the sensors
+    size_t rows;                                     // Number of rows stored
+    int64_t nextTick;                                // Tick of the next row if the run goes on
+    std::vector<Run> runs;                           // Runs of consecutive ticks, by index
+    std::vector<double> sensor1Double, sensor2Double; // Sensors with Precision::Double
+    std::vector<float> sensor1Float, sensor2Float;    // Sensors with Precision::Float
+    std::unique_ptr<ScratchFile> scratch;            // Both sensors of each row, out of core
+};
@@ -0,0 +1,291 @@
+/**
+ * @file SampleCache.cpp
+ * @brief Implementation of the SampleCache class
+ */
+
+#include "SampleCache.hpp"
+
+namespace {
+
+constexpr char MAGIC[4] = {'L', 'V', 'M', 'B'};
+
+// Smallest number of columns: time and one sensor pair
+constexpr uint32_t MIN_CHANNEL_COUNT = 3;
+
+// Alignment of the first column inside the file
+constexpr uint64_t COLUMN_ALIGNMENT = 64;
+
+// Bytes of the source hashed before they are dropped from memory, and
+// lanes of the hash (a multiple of their 8-byte words)
+constexpr size_t HASH_BLOCK_SIZE = 64 << 20;
+constexpr size_t HASH_LANES = 4;
+
+constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325;
+constexpr uint64_t FNV_PRIME = 0x100000001b3;
+
+uint64_t fnv1a(uint64_t hash, const char *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * FNV_PRIME;
+    }
+    return hash;
+}
+
+int64_t modificationTime(const std::string &path)
+{
+    return static_cast<int64_t>(
+        std::filesystem::last_write_time(path).time_since_epoch().count());
+}
+
+uint64_t columnsOffset(uint32_t channelCount)
+{
+    uint64_t offset = sizeof(SampleCache::Header) + SampleCache::TIMESTAMP_SIZE +
+                      channelCount * SampleCache::CHANNEL_NAME_SIZE;
+    return (offset + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT *
+           COLUMN_ALIGNMENT;
+}
+
+}
+
+static_assert(sizeof(SampleCache::Header) == 64,
+              "The .lvmb header must stay 64 bytes long");
+
+std::string SampleCache::pathFor(const std::string &sourcePath)
+{
+    std::filesystem::path path(sourcePath);
+    if (path.extension() == ".lvm")
+    {
+        return path.replace_extension(".lvmb").string();
+    }
+    return sourcePath + ".lvmb";
+}
+
+uint64_t SampleCache::fingerprint(const MappedFile &source)
+{
+    std::string_view contents = source.view();
+    constexpr size_t GROUP = HASH_LANES * sizeof(uint64_t);
+    static_assert(HASH_BLOCK_SIZE % GROUP == 0, "Hash blocks must hold whole groups");
+
+    // Word i of each group goes to lane i, so the lanes do not wait on
+    // each other's multiplications
+    uint64_t lanes[HASH_LANES];
+    std::fill(lanes, lanes + HASH_LANES, FNV_OFFSET);
+    size_t whole = contents.size() / GROUP * GROUP;
+    for (size_t begin = 0; begin < whole; begin += HASH_BLOCK_SIZE)
+    {
+        size_t end = std::min(begin + HASH_BLOCK_SIZE, whole);
+        for (size_t offset = begin; offset < end; offset += GROUP)
+        {
+            for (size_t lane = 0; lane < HASH_LANES; lane++)
+            {
+                uint64_t word;
+                std::memcpy(&word, contents.data() + offset + lane * sizeof(word),
+                            sizeof(word));
+                lanes[lane] = (lanes[lane] ^ word) * FNV_PRIME;
+            }
+        }
+        source.discard(begin, end - begin);
+    }
+
+    uint64_t size = contents.size();
+    uint64_t hash = fnv1a(FNV_OFFSET, reinterpret_cast<const char *>(&size),
+                          sizeof(size));
+    hash = fnv1a(hash, reinterpret_cast<const char *>(lanes), sizeof(lanes));
+    return fnv1a(hash, contents.data() + whole, contents.size() - whole);
+}
+
+SampleCache::Writer::Writer(const std::string &cachePath, const std::string &sourcePath,
+                            const MappedFile &source, const LVMHeader &lvmHeader)
+    : cachePath(cachePath), temporaryPath(cachePath + ".tmp"), lvmHeader(lvmHeader),
+      header(), started(false), finished(false)
+{
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.sourceSize = source.size();
+    header.sourceTime = modificationTime(sourcePath);
+    header.sourceHash = fingerprint(source);
+}
+
+SampleCache::Writer::~Writer()
+{
+    if (!started)
+        return;
+    file.close();
+    spills.clear();
+    std::error_code ignored;
+    for (size_t sensor = 0; sensor + 1 < header.channelCount; sensor++)
+    {
+        std::filesystem::remove(spillPath(sensor), ignored);
+    }
+    if (!finished)
+    {
+        std::filesystem::remove(temporaryPath, ignored);
+    }
+}
+
+std::string SampleCache::Writer::spillPath(size_t sensor) const
+{
+    return temporaryPath + "." + std::to_string(sensor + 1);
+}
+
+void SampleCache::Writer::start(size_t sensorCount)
+{
+    started = true;
+    header.channelCount = static_cast<uint32_t>(1 + sensorCount);
+    header.dataOffset = columnsOffset(header.channelCount);
+
+    // The header is written again by finish(), with the row count
+    file = openFileWrite(temporaryPath);
+    std::string padding(header.dataOffset, '\0');
+    file.write(padding.data(), padding.size());
+    for (size_t sensor = 0; sensor < sensorCount; sensor++)
+    {
+        spills.push_back(openFileWrite(spillPath(sensor)));
+    }
+}
+
+void SampleCache::Writer::add(const scanner::Columns &chunk)
+{
+    if (!started)
+    {
+        start(chunk.sensors.size());
+    }
+    file.write(reinterpret_cast<const char *>(chunk.time.data()),
+               chunk.size() * sizeof(double));
+    for (size_t sensor = 0; sensor < spills.size(); sensor++)
+    {
+        spills[sensor].write(reinterpret_cast<const char *>(chunk.sensors[sensor].data()),
+                             chunk.size() * sizeof(double));
+    }
+    header.rowCount += chunk.size();
+}
+
+void SampleCache::Writer::finish()
+{
+    if (!started)
+    {
+        start(2);
+    }
+    header.dataPerSecond = lvmHeader.dataPerSecond;
+
+    // Sensor columns after the time column, one after the other
+    for (size_t sensor = 0; sensor < spills.size(); sensor++)
+    {
+        spills[sensor].close();
+        std::ifstream spill = openFileRead(spillPath(sensor));
+        if (header.rowCount > 0)
+        {
+            file << spill.rdbuf();
+        }
+    }
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    char timestamp[TIMESTAMP_SIZE] = {};
+    std::strncpy(timestamp, lvmHeader.startTimestamp().c_str(),
+                 sizeof(timestamp) - 1);
+    file.write(timestamp, sizeof(timestamp));
+
+    // "time" and then the names from the header ("sensor<n>" if none)
+    char name[CHANNEL_NAME_SIZE];
+    for (uint32_t channel = 0; channel < header.channelCount; channel++)
+    {
+        std::memset(name, 0, sizeof(name));
+        std::string channelName =
+            channel == 0 ? "time" : lvmHeader.channelName(channel - 1);
+        std::strncpy(name, channelName.c_str(), sizeof(name) - 1);
+        file.write(name, sizeof(name));
+    }
+
+    file.close();
+    if (!file)
+    {
+        throw std::runtime_error("No se pudo escribir el archivo: " + temporaryPath);
+    }
+    std::filesystem::rename(temporaryPath, cachePath);
+    finished = true;
+}
+
+void SampleCache::write(const std::string &cachePath, const std::string &sourcePath,
+                        const MappedFile &source,
+                        const std::vector<scanner::Columns> &chunks,
+                        const LVMHeader &lvmHeader)
+{
+    Writer writer(cachePath, sourcePath, source, lvmHeader);
+    for (const scanner::Columns &chunk : chunks)
+    {
+        writer.add(chunk);
+    }
+    writer.finish();
+}
+
+SampleCache::SampleCache(const std::string &cachePath)
+    : file(cachePath), header(nullptr)
+{
+    if (file.size() < sizeof(Header))
+    {
+        throw std::runtime_error("Cache truncado: " + cachePath);
+    }
+    header = reinterpret_cast<const Header *>(file.view().data());
+
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header->version != VERSION)
+    {
+        throw std::runtime_error("Formato de cache desconocido: " + cachePath);
+    }
+    if (header->channelCount < MIN_CHANNEL_COUNT ||
+        header->dataOffset < columnsOffset(header->channelCount) ||
+        header->dataOffset % COLUMN_ALIGNMENT != 0 ||
+        header->dataOffset > file.size() ||
+        (file.size() - header->dataOffset) / sizeof(double) / header->channelCount <
+            header->rowCount)
+    {
+        throw std::runtime_error("Cache truncado: " + cachePath);
+    }
+}
+
+bool SampleCache::isValidFor(const std::string &sourcePath, const MappedFile &source) const
+{
+    if (header->sourceSize != source.size())
+        return false;
+    return header->sourceTime == modificationTime(sourcePath) ||
+           header->sourceHash == fingerprint(source);
+}
+
+size_t SampleCache::size() const { return header->rowCount; }
+
+double SampleCache::dataPerSecond() const { return header->dataPerSecond; }
+
+std::string_view SampleCache::startTimestamp() const
+{
+    const char *timestamp = file.view().data() + sizeof(Header);
+    return std::string_view(timestamp, strnlen(timestamp, TIMESTAMP_SIZE));
+}
+
+size_t SampleCache::channelCount() const { return header->channelCount; }
+
+std::string_view SampleCache::channelName(size_t channel) const
+{
+    const char *name = file.view().data() + sizeof(Header) + TIMESTAMP_SIZE +
+                       channel * CHANNEL_NAME_SIZE;
+    return std::string_view(name, strnlen(name, CHANNEL_NAME_SIZE));
+}
+
+const double *SampleCache::column(size_t channel) const
+{
+    return reinterpret_cast<const double *>(file.view().data() +
+                                            header->dataOffset) +
+           channel * header->rowCount;
+}
+
+void SampleCache::release(size_t first, size_t count) const
+{
+    for (size_t channel = 0; channel < channelCount(); channel++)
+    {
+        size_t offset = header->dataOffset +
+                        (channel * header->rowCount + first) * sizeof(double);
+        file.discard(offset, count * sizeof(double));
+    }
+}
@@ -0,0 +1,242 @@
+/**
+ * @file SampleCache.hpp
+ * @brief Header file for the SampleCache class - binary sidecar of an .lvm file
+ *
+ * Parsing the text .lvm file is by far the most expensive part of ingesting
+ * a storm. The first time a file is parsed its samples are written to a
+ * sidecar .lvmb file in binary columnar form; later runs map that file and
+ * use its columns directly instead of parsing the text again.
+ */
+
+#pragma once
+
+#include "LVMHeader.hpp"
+#include "file.hpp"
+#include "lib.hpp"
+#include "scanner.hpp"
+
+/**
+ * @class SampleCache
+ * @brief Read-only view over a memory mapped .lvmb sample cache
+ *
+ * File layout (all integers little endian):
+ * - Header (64 bytes): magic "LVMB", format version, row count, channel
+ *   count, sample rate, source size, modification time and hash, and the
+ *   offset of the first column
+ * - Start timestamp of the acquisition: TIMESTAMP_SIZE bytes, NUL padded
+ * - Channel names: channelCount entries of CHANNEL_NAME_SIZE bytes,
+ *   NUL padded
+ * - Columns: channelCount arrays of rowCount doubles (time, then the
+ *   sensors pair after pair), each one contiguous, starting at a 64-byte
+ *   aligned offset
+ *
+ * A cache is only used when the source .lvm still has the size recorded
+ * in its header, and either its modification time or, if that changed,
+ * the hash of its whole contents.
+ */
+class SampleCache
+{
+public:
+    // Version of the file layout, bumped on incompatible changes
+    static constexpr uint32_t VERSION = 3;
+
+    // Bytes reserved for each channel name
+    static constexpr size_t CHANNEL_NAME_SIZE = 32;
+
+    // Bytes reserved for the start timestamp
+    static constexpr size_t TIMESTAMP_SIZE = 64;
+
+    /**
+     * @struct Header
+     * @brief Fixed-size header at the start of every .lvmb file
+     */
+    struct Header
+    {
+        char magic[4];          // "LVMB"
+        uint32_t version;       // Layout version (VERSION)
+        uint64_t rowCount;      // Samples per column
+        uint32_t channelCount;  // Number of columns, time included
+        uint32_t reserved;      // Padding, always 0
+        double dataPerSecond;   // Sample rate of the acquisition
+        uint64_t sourceSize;    // Size in bytes of the source .lvm
+        uint64_t sourceHash;    // Hash of the whole source .lvm
+        uint64_t dataOffset;    // Offset of the first column
+        int64_t sourceTime;     // Modification time of the source .lvm
+    };
+
+    /**
+     * @brief Returns the sidecar cache path for a source file
+     * @param sourcePath Path to the .lvm file
+     * @return Same path with the .lvm extension replaced by .lvmb
+     */
+    static std::string pathFor(const std::string &sourcePath);
+
+    /**
+     * @brief Computes the hash of a whole source file
+     *
+     * FNV-1a over every byte of the file, 8 bytes at a time on four
+     * interleaved lanes that are then hashed together with the size. The
+     * file is read once, block by block, and each block is dropped from
+     * memory once hashed.
+     *
+     * @param source Mapping of the source file
+     * @return 64-bit hash
+     */
+    static uint64_t fingerprint(const MappedFile &source);
+
+    /**
+     * @class Writer
+     * @brief Writes a cache file while the samples are being parsed
+     *
+     * The time column goes straight to the cache file and every sensor
+     * column to a spill file of its own; finish() appends the spill files
+     * after the time column and fills in the header. Only the chunk being
+     * added is ever held in memory, whatever the length of the storm.
+     * The file is written under a temporary name and renamed at the end,
+     * so an interrupted run never leaves a truncated cache behind.
+     */
+    class Writer
+    {
+    public:
+        /**
+         * @brief Starts a cache file
+         * @param cachePath Path of the .lvmb file to create
+         * @param sourcePath Path of the source file (for its modification time)
+         * @param source Mapping of the source file (hashed right away)
+         * @param header Header of the source (sample rate, start timestamp
+         *        and channel names)
+         */
+        Writer(const std::string &cachePath, const std::string &sourcePath,
+               const MappedFile &source, const LVMHeader &header);
+
+        /**
+         * @brief Removes the temporary files if finish() was not reached
+         */
+        ~Writer();
+
+        Writer(const Writer &) = delete;
+        Writer &operator=(const Writer &) = delete;
+
+        /**
+         * @brief Appends parsed samples
+         * @param chunk Next parsed samples, in file order
+         * @throws std::runtime_error if the files cannot be written
+         */
+        void add(const scanner::Columns &chunk);
+
+        /**
+         * @brief Completes the cache file and moves it into place
+         * @throws std::runtime_error if the file cannot be written
+         */
+        void finish();
+
+    private:
+        std::string cachePath;            // Final path of the cache
+        std::string temporaryPath;        // Path while it is written
+        const LVMHeader &lvmHeader;       // Header of the source
+        Header header;                    // Header of the cache
+        std::ofstream file;               // Cache file (header, time column)
+        std::vector<std::ofstream> spills; // One spill file per sensor column
+        bool started;                     // The files were created
+        bool finished;                    // finish() completed
+
+        /**
+         * @brief Returns the path of the spill file of a sensor column
+         */
+        std::string spillPath(size_t sensor) const;
+
+        /**
+         * @brief Creates the files once the number of channels is known
+         * @param sensorCount Number of sensor columns
+         */
+        void start(size_t sensorCount);
+    };
+
+    /**
+     * @brief Writes a cache file for parsed samples
+     *
+     * The file is written under a temporary name and renamed at the end,
+     * so an interrupted run never leaves a truncated cache behind.
+     *
+     * @param cachePath Path of the .lvmb file to create
+     * @param sourcePath Path of the source file (for its modification time)
+     * @param source Mapping of the source file (for its hash)
+     * @param chunks Parsed samples, in file order
+     * @param header Header of the source (sample rate, start timestamp and
+     *        channel names)
+     * @throws std::runtime_error if the file cannot be written
+     */
+    static void write(const std::string &cachePath, const std::string &sourcePath,
+                      const MappedFile &source,
+                      const std::vector<scanner::Columns> &chunks,
+                      const LVMHeader &header);
+
+    /**
+     * @brief Maps an existing cache file and checks its structure
+     * @param cachePath Path of the .lvmb file
+     * @throws std::runtime_error if the file is missing, truncated or has
+     *         an unknown layout version
+     */
+    explicit SampleCache(const std::string &cachePath);
+
+    /**
+     * @brief Checks whether the cache was built from the given source
+     *
+     * Size and modification time are the quick check: the whole source is
+     * only hashed when the size matches but the time does not (e.g. the
+     * file was copied).
+     *
+     * @param sourcePath Path of the source file
+     * @param source Mapping of the source file
+     * @return True if the size matches and the time or the hash do
+     */
+    bool isValidFor(const std::string &sourcePath, const MappedFile &source) const;
+
+    /**
+     * @brief Returns the number of samples in the cache
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the sample rate recorded in the cache
+     */
+    double dataPerSecond() const;
+
+    /**
+     * @brief Returns the start timestamp recorded in the cache (may be empty)
+     */
+    std::string_view startTimestamp() const;
+
+    /**
+     * @brief Returns the number of columns, time included
+     */
+    size_t channelCount() const;
+
+    /**
+     * @brief Returns the name of a channel (0 is time)
+     * @param channel Channel index
+     */
+    std::string_view channelName(size_t channel) const;
+
+    /**
+     * @brief Returns a pointer to a mapped column (0 is time)
+     * @param channel Channel index
+     * @return Pointer to size() contiguous doubles
+     */
+    const double *column(size_t channel) const;
+
+    /**
+     * @brief Drops a range of rows of every column from memory
+     *
+     * For callers that walk the columns once: the rows are read from the
+     * file again if touched later.
+     *
+     * @param first First row of the range
+     * @param count Number of rows in the range
+     */
+    void release(size_t first, size_t count) const;
+
+private:
+    MappedFile file;      // Mapping of the whole .lvmb file
+    const Header *header; // Header at the start of the mapping
+};
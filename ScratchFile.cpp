@@ -0,0 +1,115 @@
+/**
+ * @file ScratchFile.cpp
+ * @brief Implementation of the ScratchFile class
+ */
+
+#include "ScratchFile.hpp"
+
+namespace
+{
+
+constexpr size_t NO_CHUNK = static_cast<size_t>(-1); // No chunk touched yet
+
+}
+
+ScratchFile::ScratchFile(const std::string &directory, size_t budget, size_t recordSize)
+    : fd(-1), recordSize(recordSize), recordsPerChunk(CHUNK_BYTES / recordSize),
+      maxResident(std::max<size_t>(1, budget / CHUNK_BYTES)), records(0),
+      current(NO_CHUNK)
+{
+    std::string path = (std::filesystem::path(directory) / "drop_finder-XXXXXX").string();
+    fd = mkstemp(path.data());
+    if (fd == -1)
+    {
+        throw std::runtime_error("No se pudo crear el archivo temporal en: " + directory);
+    }
+    unlink(path.c_str());
+}
+
+ScratchFile::~ScratchFile()
+{
+    clear();
+    close(fd);
+}
+
+char *ScratchFile::append()
+{
+    size_t chunk = records / recordsPerChunk;
+    if (chunk == chunks.size())
+    {
+        // Reserve the disk space now, a full disk would otherwise end the
+        // process with SIGBUS when the page is written
+        int error = posix_fallocate(fd, static_cast<off_t>(chunk * CHUNK_BYTES), CHUNK_BYTES);
+        if (error != 0)
+        {
+            throw std::runtime_error(std::string("No se pudo agrandar el archivo temporal: ") +
+                                     std::strerror(error));
+        }
+        void *mapping = mmap(nullptr, CHUNK_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                             static_cast<off_t>(chunk * CHUNK_BYTES));
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error("No se pudo hacer memory mapping del archivo temporal");
+        }
+        madvise(mapping, CHUNK_BYTES, MADV_SEQUENTIAL);
+        chunks.push_back(static_cast<char *>(mapping));
+    }
+    touch(chunk);
+    return chunks[chunk] + (records++ % recordsPerChunk) * recordSize;
+}
+
+const char *ScratchFile::operator[](size_t index) const
+{
+    size_t chunk = index / recordsPerChunk;
+    touch(chunk);
+    return chunks[chunk] + (index % recordsPerChunk) * recordSize;
+}
+
+void ScratchFile::touch(size_t chunk) const
+{
+    if (chunk == current)
+        return;
+    current = chunk;
+
+    auto found = std::find(resident.begin(), resident.end(), chunk);
+    if (found != resident.end())
+    {
+        resident.erase(found);
+        resident.push_back(chunk);
+        return;
+    }
+
+    // First time in a while: ask for the next chunk as well
+    resident.push_back(chunk);
+    if (chunk + 1 < chunks.size())
+    {
+        madvise(chunks[chunk + 1], CHUNK_BYTES, MADV_WILLNEED);
+    }
+    while (resident.size() > maxResident)
+    {
+        madvise(chunks[resident.front()], CHUNK_BYTES, MADV_DONTNEED);
+        resident.pop_front();
+    }
+}
+
+size_t ScratchFile::size() const { return records; }
+
+size_t ScratchFile::bytes() const { return chunks.size() * CHUNK_BYTES; }
+
+size_t ScratchFile::budget() const { return maxResident * CHUNK_BYTES; }
+
+void ScratchFile::clear()
+{
+    for (char *chunk : chunks)
+    {
+        munmap(chunk, CHUNK_BYTES);
+    }
+    chunks.clear();
+    resident.clear();
+    current = NO_CHUNK;
+    records = 0;
+    if (ftruncate(fd, 0) != 0)
+    {
+        // The space is given back when the descriptor is closed anyway
+    }
+}
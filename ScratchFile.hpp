@@ -0,0 +1,96 @@
+/**
+ * @file ScratchFile.hpp
+ * @brief Header file for the ScratchFile class - out-of-core record storage
+ *
+ * With --out-of-core the whole signals kept by drop_finder --batch do not
+ * live in RAM: their samples are written to a memory mapped scratch file
+ * and paged in and out by the kernel as the steps walk through them, so a
+ * campaign longer than the RAM of the machine can still be processed.
+ */
+
+#pragma once
+
+#include "lib.hpp"
+
+/**
+ * @class ScratchFile
+ * @brief Append-only array of fixed-size records in a mapped scratch file
+ *
+ * The file grows in chunks of CHUNK_BYTES, each one mapped on its own.
+ * Chunks are expected to be walked front to back (they are mapped with
+ * MADV_SEQUENTIAL and the next chunk is prefetched with MADV_WILLNEED when
+ * one is first touched); at most budget / CHUNK_BYTES chunks are kept
+ * resident, the least recently touched one being dropped with
+ * MADV_DONTNEED (its data stays in the file). The file is unlinked as soon
+ * as it is created, so it disappears with the process whatever happens.
+ */
+class ScratchFile
+{
+public:
+    static constexpr size_t CHUNK_BYTES = 8 << 20; // Bytes per mapped chunk
+
+    /**
+     * @brief Creates an empty scratch file
+     * @param directory Directory the file is created in
+     * @param budget Bytes of the file allowed to stay resident (at least
+     *        one chunk)
+     * @param recordSize Bytes per record (a divisor of CHUNK_BYTES)
+     * @throws std::runtime_error if the file cannot be created
+     */
+    ScratchFile(const std::string &directory, size_t budget, size_t recordSize);
+
+    ~ScratchFile();
+
+    ScratchFile(const ScratchFile &) = delete;
+    ScratchFile &operator=(const ScratchFile &) = delete;
+
+    /**
+     * @brief Appends a record at the end of the file
+     * @return Pointer to the new record, recordSize writable bytes
+     * @throws std::runtime_error if there is no room left for the file
+     */
+    char *append();
+
+    /**
+     * @brief Returns a record
+     * @param index Index of the record
+     * @return Pointer to recordSize bytes, valid until the next call
+     */
+    const char *operator[](size_t index) const;
+
+    /**
+     * @brief Returns the number of records stored
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the size of the file, in bytes
+     */
+    size_t bytes() const;
+
+    /**
+     * @brief Returns the largest number of bytes kept resident
+     */
+    size_t budget() const;
+
+    /**
+     * @brief Removes all records and shrinks the file
+     */
+    void clear();
+
+private:
+    int fd;                               // Descriptor of the unlinked file
+    size_t recordSize;                    // Bytes per record
+    size_t recordsPerChunk;               // Records in each chunk
+    size_t maxResident;                   // Chunks allowed to stay resident
+    size_t records;                       // Records stored
+    std::vector<char *> chunks;           // Mapping of every chunk
+    mutable std::deque<size_t> resident;  // Chunks touched, least recent first
+    mutable size_t current;               // Chunk touched last
+
+    /**
+     * @brief Marks a chunk as used, dropping the oldest one over the budget
+     * @param chunk Chunk about to be read or written
+     */
+    void touch(size_t chunk) const;
+};
@@ -0,0 +1,435 @@
+/**
+ * @file SignalArchive.cpp
+ * @brief Implementation of the SignalArchive class
+ */
+
+#include "SignalArchive.hpp"
+#include "file.hpp"
+
+namespace {
+
+constexpr char MAGIC[4] = {'L', 'V', 'M', 'A'};
+
+// Order of the delta applied to each column: time is stored as delta of
+// deltas, the sensors as plain deltas
+int columnOrder(size_t column) { return column == 0 ? 2 : 1; }
+
+// Quantized values are kept well inside int64 so deltas cannot overflow
+constexpr double MAX_QUANTIZED = double(int64_t(1) << 60);
+
+uint64_t zigzag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^
+           static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/**
+ * @brief Appends one column of a block to the output words
+ *
+ * Layout: first value, first delta, (width | wordCount << 32), packed
+ * residuals of rows 1..n-1.
+ */
+void encodeColumn(const int64_t *values, size_t rows, int order,
+                  std::vector<uint64_t> &words)
+{
+    int64_t firstDelta = rows > 1 ? values[1] - values[0] : 0;
+    std::vector<uint64_t> residuals(rows - 1);
+    uint64_t maxResidual = 0;
+    int64_t previousDelta = firstDelta;
+    for (size_t i = 1; i < rows; i++)
+    {
+        int64_t delta = values[i] - values[i - 1];
+        residuals[i - 1] = zigzag(order == 2 ? delta - previousDelta : delta);
+        maxResidual |= residuals[i - 1];
+        previousDelta = delta;
+    }
+    unsigned width = maxResidual ? 64 - __builtin_clzll(maxResidual) : 0;
+
+    size_t headerPosition = words.size();
+    words.push_back(static_cast<uint64_t>(values[0]));
+    words.push_back(static_cast<uint64_t>(firstDelta));
+    words.push_back(0);
+
+    if (width > 0)
+    {
+        uint64_t accumulator = 0;
+        unsigned used = 0;
+        for (uint64_t residual : residuals)
+        {
+            accumulator |= residual << used;
+            if (used + width >= 64)
+            {
+                words.push_back(accumulator);
+                unsigned spill = used + width - 64;
+                accumulator = spill ? residual >> (width - spill) : 0;
+                used = spill;
+            }
+            else
+            {
+                used += width;
+            }
+        }
+        if (used > 0)
+        {
+            words.push_back(accumulator);
+        }
+    }
+
+    uint64_t wordCount = words.size() - headerPosition - 3;
+    words[headerPosition + 2] = width | (wordCount << 32);
+}
+
+/**
+ * @brief Decodes one column of a block
+ * @param end End of the archive words
+ * @return Pointer just past the column
+ * @throws std::runtime_error if the column does not fit in the archive
+ */
+const uint64_t *decodeColumn(const uint64_t *words, const uint64_t *end,
+                             size_t rows, int order, double scale,
+                             double *output)
+{
+    if (end - words < 3)
+    {
+        throw std::runtime_error("Archivo .lvma truncado");
+    }
+    int64_t value = static_cast<int64_t>(words[0]);
+    int64_t previousDelta = static_cast<int64_t>(words[1]);
+    unsigned width = static_cast<uint32_t>(words[2]);
+    uint64_t wordCount = words[2] >> 32;
+    const uint64_t *packed = words + 3;
+    if (width > 64 || wordCount < ((rows - 1) * width + 63) / 64 ||
+        wordCount > static_cast<uint64_t>(end - packed))
+    {
+        throw std::runtime_error("Archivo .lvma truncado");
+    }
+    uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+
+    output[0] = value / scale;
+    size_t bit = 0;
+    for (size_t i = 1; i < rows; i++, bit += width)
+    {
+        uint64_t residual = 0;
+        if (width > 0)
+        {
+            size_t word = bit >> 6, offset = bit & 63;
+            residual = packed[word] >> offset;
+            if (offset + width > 64)
+            {
+                residual |= packed[word + 1] << (64 - offset);
+            }
+            residual &= mask;
+        }
+        int64_t delta = unzigzag(residual);
+        if (order == 2)
+        {
+            delta += previousDelta;
+            previousDelta = delta;
+        }
+        value += delta;
+        output[i] = value / scale;
+    }
+    return packed + wordCount;
+}
+
+}
+
+static_assert(sizeof(SignalArchive::Header) == 64,
+              "The .lvma header must stay 64 bytes long");
+
+bool SignalArchive::isArchive(std::string_view contents)
+{
+    return contents.size() >= sizeof(MAGIC) &&
+           std::memcmp(contents.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+SignalArchive::Summary
+SignalArchive::write(const std::string &archivePath,
+                     const std::vector<scanner::Columns> &chunks,
+                     double sensorResolution, uint64_t sourceSize,
+                     double dataPerSecond)
+{
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.blockRows = BLOCK_ROWS;
+    header.timeScale = 1 / DEFAULT_RESOLUTION;
+    header.sensorScale = 1 / sensorResolution;
+    header.sourceSize = sourceSize;
+    header.channelCount = static_cast<uint32_t>(
+        1 + (chunks.empty() ? 2 : chunks[0].sensors.size()));
+    header.dataPerSecond = static_cast<uint32_t>(std::lround(dataPerSecond));
+
+    Summary summary = {};
+    std::vector<BlockIndex> blocks;
+    std::vector<std::vector<int64_t>> quantized(header.channelCount);
+    std::vector<uint64_t> words;
+    BlockIndex current = {};
+
+    std::ofstream file = openFileWrite(archivePath);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    auto quantize = [&](double value, double scale, double &maxError)
+    {
+        double scaled = value * scale;
+        if (!(std::abs(scaled) < MAX_QUANTIZED))
+        {
+            throw std::runtime_error("Valor fuera de rango para el archivo: " +
+                                     std::to_string(value));
+        }
+        int64_t result = std::llround(scaled);
+        maxError = std::max(maxError, std::abs(value - result / scale));
+        return result;
+    };
+
+    auto flushBlock = [&]
+    {
+        size_t rows = quantized[0].size();
+        if (rows == 0)
+            return;
+        words.clear();
+        words.push_back(rows);
+        for (size_t column = 0; column < quantized.size(); column++)
+        {
+            encodeColumn(quantized[column].data(), rows, columnOrder(column),
+                         words);
+            quantized[column].clear();
+        }
+        current.offset = static_cast<uint64_t>(file.tellp());
+        file.write(reinterpret_cast<const char *>(words.data()),
+                   words.size() * sizeof(uint64_t));
+        blocks.push_back(current);
+        current.firstRow += rows;
+    };
+
+    for (const scanner::Columns &chunk : chunks)
+    {
+        for (size_t i = 0; i < chunk.size(); i++)
+        {
+            if (quantized[0].empty())
+            {
+                current.minTime = current.maxTime = chunk.time[i];
+            }
+            current.minTime = std::min(current.minTime, chunk.time[i]);
+            current.maxTime = std::max(current.maxTime, chunk.time[i]);
+            quantized[0].push_back(
+                quantize(chunk.time[i], header.timeScale, summary.maxTimeError));
+            for (size_t column = 1; column < quantized.size(); column++)
+            {
+                quantized[column].push_back(
+                    quantize(chunk.sensors[column - 1][i], header.sensorScale,
+                             summary.maxSensorError));
+            }
+            if (quantized[0].size() == BLOCK_ROWS)
+            {
+                flushBlock();
+            }
+        }
+    }
+    flushBlock();
+
+    header.rowCount = current.firstRow;
+    header.blockCount = blocks.size();
+    header.indexOffset = static_cast<uint64_t>(file.tellp());
+    file.write(reinterpret_cast<const char *>(blocks.data()),
+               blocks.size() * sizeof(BlockIndex));
+    summary.rows = header.rowCount;
+    summary.archiveSize = static_cast<uint64_t>(file.tellp());
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    if (!file)
+    {
+        throw std::runtime_error("No se pudo escribir el archivo: " + archivePath);
+    }
+    return summary;
+}
+
+SignalArchive::SignalArchive(std::string_view contents)
+    : contents(contents), header(nullptr), index(nullptr), channels(0)
+{
+    if (contents.size() < sizeof(Header) || !isArchive(contents))
+    {
+        throw std::runtime_error("No es un archivo .lvma");
+    }
+    header = reinterpret_cast<const Header *>(contents.data());
+    if (header->version != VERSION)
+    {
+        throw std::runtime_error("Version de .lvma desconocida: " +
+                                 std::to_string(header->version));
+    }
+    channels = header->channelCount;
+    if (channels < 3)
+    {
+        throw std::runtime_error("Archivo .lvma sin sensores");
+    }
+    if (header->indexOffset > contents.size() ||
+        (contents.size() - header->indexOffset) / sizeof(BlockIndex) <
+            header->blockCount)
+    {
+        throw std::runtime_error("Archivo .lvma truncado");
+    }
+    index = reinterpret_cast<const BlockIndex *>(contents.data() +
+                                                 header->indexOffset);
+}
+
+size_t SignalArchive::size() const { return header->rowCount; }
+
+size_t SignalArchive::channelCount() const { return channels; }
+
+double SignalArchive::dataPerSecond() const
+{
+    return header->dataPerSecond == 0 ? DATA_PER_SECOND
+                                      : header->dataPerSecond;
+}
+
+double SignalArchive::compressionRatio() const
+{
+    return static_cast<double>(header->sourceSize) / contents.size();
+}
+
+void SignalArchive::decodeBlock(size_t block, double from, double to,
+                                scanner::Columns &chunk) const
+{
+    // The block must lie inside the archive before anything is decoded
+    uint64_t offset = index[block].offset;
+    if (offset % sizeof(uint64_t) != 0 || offset > contents.size() ||
+        contents.size() - offset < sizeof(uint64_t))
+    {
+        throw std::runtime_error("Archivo .lvma truncado");
+    }
+    const uint64_t *words =
+        reinterpret_cast<const uint64_t *>(contents.data() + offset);
+    const uint64_t *end = words + (contents.size() - offset) / sizeof(uint64_t);
+    size_t rows = words[0];
+    if (rows == 0 || rows > header->blockRows)
+    {
+        throw std::runtime_error("Archivo .lvma truncado");
+    }
+    words++;
+
+    size_t start = chunk.size();
+    chunk.sensors.resize(channels - 1);
+    for (size_t column = 0; column < channels; column++)
+    {
+        std::vector<double> &values =
+            column == 0 ? chunk.time : chunk.sensors[column - 1];
+        values.resize(start + rows);
+        double scale = column == 0 ? header->timeScale : header->sensorScale;
+        words = decodeColumn(words, end, rows, columnOrder(column), scale,
+                             values.data() + start);
+    }
+
+    // Blocks on the edges of the range keep only the rows inside it
+    if (index[block].minTime < from || index[block].maxTime > to)
+    {
+        size_t kept = start;
+        for (size_t i = start; i < start + rows; i++)
+        {
+            if (chunk.time[i] < from || chunk.time[i] > to)
+                continue;
+            chunk.time[kept] = chunk.time[i];
+            for (std::vector<double> &sensor : chunk.sensors)
+            {
+                sensor[kept] = sensor[i];
+            }
+            kept++;
+        }
+        chunk.time.resize(kept);
+        for (std::vector<double> &sensor : chunk.sensors)
+        {
+            sensor.resize(kept);
+        }
+    }
+}
+
+std::vector<size_t> SignalArchive::selectBlocks(double from, double to) const
+{
+    std::vector<size_t> selected;
+    for (size_t block = 0; block < header->blockCount; block++)
+    {
+        if (index[block].maxTime >= from && index[block].minTime <= to)
+        {
+            selected.push_back(block);
+        }
+    }
+    return selected;
+}
+
+std::vector<scanner::Columns> SignalArchive::decodeBlocks(const std::vector<size_t> &selected,
+                                                          double from, double to,
+                                                          size_t threads) const
+{
+    size_t groups = std::max<size_t>(1, std::min(threads, selected.size()));
+    std::vector<scanner::Columns> chunks(groups);
+    std::vector<std::exception_ptr> errors(groups);
+    auto decodeGroup = [&](size_t group)
+    {
+        try
+        {
+            size_t begin = group * selected.size() / groups;
+            size_t end = (group + 1) * selected.size() / groups;
+            size_t rows = (end - begin) * header->blockRows;
+            chunks[group].time.reserve(rows);
+            chunks[group].sensors.resize(channels - 1);
+            for (std::vector<double> &sensor : chunks[group].sensors)
+            {
+                sensor.reserve(rows);
+            }
+            for (size_t i = begin; i < end; i++)
+            {
+                decodeBlock(selected[i], from, to, chunks[group]);
+            }
+        }
+        catch (...)
+        {
+            errors[group] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t group = 1; group < groups; group++)
+    {
+        workers.emplace_back(decodeGroup, group);
+    }
+    decodeGroup(0);
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    for (std::exception_ptr &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+    return chunks;
+}
+
+std::vector<scanner::Columns> SignalArchive::decode(double from, double to,
+                                                    size_t threads) const
+{
+    return decodeBlocks(selectBlocks(from, to), from, to, threads);
+}
+
+void SignalArchive::decode(double from, double to, size_t threads,
+                           const std::function<void(const scanner::Columns &)> &onChunk) const
+{
+    std::vector<size_t> selected = selectBlocks(from, to);
+    size_t batchSize = std::max<size_t>(1, threads) * BATCH_BLOCKS;
+    for (size_t begin = 0; begin < selected.size(); begin += batchSize)
+    {
+        std::vector<size_t> batch(selected.begin() + begin,
+                                  selected.begin() + std::min(begin + batchSize, selected.size()));
+        for (const scanner::Columns &chunk : decodeBlocks(batch, from, to, threads))
+        {
+            onChunk(chunk);
+        }
+    }
+}
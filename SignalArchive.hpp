@@ -0,0 +1,211 @@
+/**
+ * @file SignalArchive.hpp
+ * @brief Header file for the SignalArchive class - compressed storm storage
+ *
+ * Text .lvm files spend ~30 bytes per sample on values that the ADC only
+ * resolves to a few thousand levels. The .lvma archive format stores the
+ * same samples quantized to a fixed resolution, delta encoded, zigzagged
+ * and bit packed in independent blocks, with a block index that allows
+ * decoding any time range without touching the rest of the file.
+ */
+
+#pragma once
+
+#include "constants.hpp"
+#include "lib.hpp"
+#include "scanner.hpp"
+
+/**
+ * @class SignalArchive
+ * @brief Read-only view over a .lvma archive, plus the encoder
+ *
+ * File layout (all integers little endian, everything 8-byte aligned):
+ * - Header (64 bytes): magic "LVMA", version, row count, rows per block,
+ *   block count, quantization scales, source size, index offset, channel
+ *   count and sample rate
+ * - Blocks, one after the other. Each block stores, for each column
+ *   (time, then the sensors pair after pair): the first quantized value,
+ *   the first delta, the bit width and word count, and the packed
+ *   residuals of the remaining rows. Residuals are zigzagged deltas for the sensors and
+ *   zigzagged deltas of deltas for time (which is almost always constant
+ *   step, so it packs to 0 bits per row)
+ * - Block index: one BlockIndex entry per block
+ *
+ * Values are quantized as round(value * scale) and decoded as
+ * quantized / scale. With the default scales (1e6) every value written
+ * with 6 decimals, as LabVIEW does, decodes to exactly the same double the
+ * text parser returns.
+ */
+class SignalArchive
+{
+public:
+    // Version of the file layout, bumped on incompatible changes
+    static constexpr uint32_t VERSION = 2;
+
+    // Rows per block (the unit of random access)
+    static constexpr uint32_t BLOCK_ROWS = 4096;
+
+    // Default quantization step of time (seconds) and sensors (volts)
+    static constexpr double DEFAULT_RESOLUTION = 1e-6;
+
+    /**
+     * @struct Header
+     * @brief Fixed-size header at the start of every .lvma file
+     */
+    struct Header
+    {
+        char magic[4];        // "LVMA"
+        uint32_t version;     // Layout version (VERSION)
+        uint64_t rowCount;    // Total samples
+        uint32_t blockRows;   // Rows per block (last block may be shorter)
+        uint32_t blockCount;  // Number of blocks
+        double timeScale;     // Quantization scale of the time column
+        double sensorScale;   // Quantization scale of the sensor columns
+        uint64_t sourceSize;  // Size of the text file it was built from
+        uint64_t indexOffset;   // Offset of the block index
+        uint32_t channelCount;  // Number of columns, time included
+        uint32_t dataPerSecond; // Sample rate in Hz (0: DATA_PER_SECOND)
+    };
+
+    /**
+     * @struct BlockIndex
+     * @brief Location and time span of one block
+     */
+    struct BlockIndex
+    {
+        uint64_t offset;   // Offset of the block in the file
+        uint64_t firstRow; // Global index of the first row of the block
+        double minTime;    // Smallest time in the block
+        double maxTime;    // Largest time in the block
+    };
+
+    /**
+     * @struct Summary
+     * @brief Figures reported after writing an archive
+     */
+    struct Summary
+    {
+        uint64_t rows;           // Samples written
+        uint64_t archiveSize;    // Bytes of the archive
+        double maxTimeError;     // Largest |time - decoded time|
+        double maxSensorError;   // Largest |sensor - decoded sensor|
+    };
+
+    /**
+     * @brief Checks whether a buffer starts with the archive magic
+     * @param contents File contents
+     * @return True if the contents look like a .lvma archive
+     */
+    static bool isArchive(std::string_view contents);
+
+    /**
+     * @brief Encodes parsed samples into a .lvma archive
+     * @param archivePath Path of the archive to create
+     * @param chunks Parsed samples, in file order
+     * @param sensorResolution Quantization step of the sensors (ADC LSB)
+     * @param sourceSize Size of the text file the samples came from
+     * @param dataPerSecond Sample rate of the acquisition (whole Hz)
+     * @return Sizes and quantization errors of the written archive
+     * @throws std::runtime_error if a value cannot be quantized or the
+     *         file cannot be written
+     */
+    static Summary write(const std::string &archivePath,
+                         const std::vector<scanner::Columns> &chunks,
+                         double sensorResolution, uint64_t sourceSize,
+                         double dataPerSecond);
+
+    /**
+     * @brief Opens an archive from its mapped contents
+     * @param contents Archive bytes (must outlive this object)
+     * @throws std::runtime_error if the archive is truncated or has an
+     *         unknown layout version
+     */
+    explicit SignalArchive(std::string_view contents);
+
+    /**
+     * @brief Returns the number of samples in the archive
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the number of columns, time included
+     */
+    size_t channelCount() const;
+
+    /**
+     * @brief Returns the sample rate of the archived acquisition
+     */
+    double dataPerSecond() const;
+
+    /**
+     * @brief Returns the size of the source text over the archive size
+     */
+    double compressionRatio() const;
+
+    /**
+     * @brief Decodes all rows with from <= time <= to
+     *
+     * Only the blocks whose time span overlaps the range are decoded. The
+     * blocks are split among the threads; each thread decodes its blocks
+     * into its own chunk and the chunks are returned in file order.
+     *
+     * @param from Start of the time range (seconds)
+     * @param to End of the time range (seconds)
+     * @param threads Number of decoding threads
+     * @return Decoded chunks, in file order
+     */
+    std::vector<scanner::Columns> decode(double from, double to,
+                                         size_t threads) const;
+
+    /**
+     * @brief Decodes all rows with from <= time <= to, a few blocks at a time
+     *
+     * Same rows as decode(from, to, threads), but the selected blocks are
+     * decoded BATCH_BLOCKS per thread at a time and handed over before the
+     * next ones are decoded, so memory does not grow with the range.
+     *
+     * @param from Start of the time range (seconds)
+     * @param to End of the time range (seconds)
+     * @param threads Number of decoding threads
+     * @param onChunk Called with every decoded chunk, in file order
+     */
+    void decode(double from, double to, size_t threads,
+                const std::function<void(const scanner::Columns &)> &onChunk) const;
+
+private:
+    static constexpr size_t BATCH_BLOCKS = 16; // Blocks per thread per batch
+
+
+    std::string_view contents; // Archive bytes
+    const Header *header;      // Header at the start of the archive
+    const BlockIndex *index;   // Block index at header->indexOffset
+    size_t channels;           // Columns per block, time included
+
+    /**
+     * @brief Decodes one block, appending its rows within [from, to]
+     * @param block Block number
+     * @param from Start of the time range (seconds)
+     * @param to End of the time range (seconds)
+     * @param chunk Output columns
+     * @throws std::runtime_error if the block does not fit in the archive
+     */
+    void decodeBlock(size_t block, double from, double to,
+                     scanner::Columns &chunk) const;
+
+    /**
+     * @brief Returns the blocks whose time span overlaps [from, to]
+     */
+    std::vector<size_t> selectBlocks(double from, double to) const;
+
+    /**
+     * @brief Decodes a run of selected blocks, split among the threads
+     * @param blocks Selected blocks, in file order
+     * @param from Start of the time range (seconds)
+     * @param to End of the time range (seconds)
+     * @param threads Number of decoding threads
+     * @return Decoded chunks, in file order
+     */
+    std::vector<scanner::Columns> decodeBlocks(const std::vector<size_t> &blocks,
+                                               double from, double to,
+                                               size_t threads) const;
+};
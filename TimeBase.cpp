@@ -0,0 +1,22 @@
+/**
+ * @file TimeBase.cpp
+ * @brief Implementation of the TimeBase class
+ */
+
+#include "TimeBase.hpp"
+
+TimeBase::TimeBase(double dataPerSecond, double origin) : rate(dataPerSecond), start(origin) {}
+
+int64_t TimeBase::tick(double time) const
+{
+    return std::llround((time - start) * rate);
+}
+
+double TimeBase::time(int64_t tick) const
+{
+    return start + static_cast<double>(tick) / rate;
+}
+
+double TimeBase::dataPerSecond() const { return rate; }
+
+double TimeBase::origin() const { return start; }
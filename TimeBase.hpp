@@ -0,0 +1,66 @@
+/**
+ * @file TimeBase.hpp
+ * @brief Header file for the TimeBase class - sample ticks of an acquisition
+ *
+ * The samples of an acquisition are evenly spaced, so once read their time
+ * is carried as an integer tick (the index of the sample at the sample rate)
+ * instead of a double. Gaps are then found on integer differences, and the
+ * time in seconds is only rebuilt where it is written out.
+ */
+
+#pragma once
+
+#include "constants.hpp"
+#include "lib.hpp"
+
+/**
+ * @class TimeBase
+ * @brief Conversion between times in seconds and sample ticks
+ *
+ * Tick 0 is the origin, the time of the first sample read (0 in the files
+ * LabVIEW writes, whose times are relative to the acquisition start, but
+ * not in an excerpt or a file that starts at an arbitrary timestamp), and
+ * each tick is 1 / dataPerSecond seconds. Times are rebuilt as origin +
+ * tick / dataPerSecond, so an origin off the grid of the sample rate is
+ * kept instead of being snapped to it. With origin 0, a time that falls on
+ * a tick, as every time written by LabVIEW does, converts back to the very
+ * same double: both are the value of tick / dataPerSecond correctly
+ * rounded.
+ */
+class TimeBase
+{
+public:
+    /**
+     * @brief Constructor for a time base
+     * @param dataPerSecond Sample rate, ticks per second
+     * @param origin Time of tick 0, in seconds
+     */
+    explicit TimeBase(double dataPerSecond = DATA_PER_SECOND, double origin = 0);
+
+    /**
+     * @brief Converts a time to the nearest tick
+     * @param time Time in seconds
+     */
+    int64_t tick(double time) const;
+
+    /**
+     * @brief Converts a tick back to a time
+     * @param tick Tick of a sample
+     * @return Time in seconds
+     */
+    double time(int64_t tick) const;
+
+    /**
+     * @brief Returns the sample rate
+     */
+    double dataPerSecond() const;
+
+    /**
+     * @brief Returns the time of tick 0, in seconds
+     */
+    double origin() const;
+
+private:
+    double rate;  // Ticks per second
+    double start; // Time of tick 0
+};
@@ -0,0 +1,137 @@
+/**
+ * @file baseline_bench.cpp
+ * @brief Throughput of the baseline estimators at WINDOW_SIZE (make bench)
+ *
+ * Builds a synthetic signal (10M samples by default): slow drifts around
+ * an offset, noise rounded to the 1e-6 V of the .lvm files and a drop of
+ * both sensors every 2000 rows, which is what pulls the mean away from the
+ * median. Every baseline is then run on the same signal, with a window of
+ * WINDOW_SIZE samples:
+ * - alone, on the sensor1 column: WindowSums (mean), RollingMedian and
+ *   HistogramMedian, pushing a value and taking the estimate on each row
+ * - through normalizeWithRolling, on both sensors and the given threads
+ *
+ * and the millions of rows per second of each one are printed, with the
+ * largest distance of HistogramMedian to the exact median.
+ *
+ * Usage: baseline_bench [samples] [threads]
+ */
+
+#include "HistogramMedian.hpp"
+#include "RollingMedian.hpp"
+#include "normalizer.hpp"
+#include "tests/synthetic_signal.hpp"
+
+namespace
+{
+
+constexpr size_t DROP_EVERY = 2000; // Rows between two synthetic drops
+
+/**
+ * @brief Slow drifts around small offsets, noise and a drop of both
+ *        sensors every DROP_EVERY rows
+ */
+const SyntheticSignal SIGNAL = {0.1, 0.05, 1e-5, -0.05, 0.03, 3e-6, 0.004, DROP_EVERY};
+
+/**
+ * @brief Runs one estimator and prints its throughput
+ * @param run Processes the signal and returns a checksum of its output
+ */
+void measure(const std::string &name, size_t rows, const std::function<double()> &run)
+{
+    auto start = std::chrono::steady_clock::now();
+    double checksum = run();
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::left << std::setw(34) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(7) << rows / 1e6 / seconds
+              << " M rows/s  (checksum " << std::setprecision(3) << checksum << ")"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t samples = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    size_t threads = argc > 2 ? std::stoul(argv[2])
+                              : std::max(1u, std::thread::hardware_concurrency());
+    size_t windowSize = normalizer::RollingNormalizer::halfWindowFor(DATA_PER_SECOND) * 2 + 1;
+
+    SampleBuffer data(SampleBuffer::Precision::Double);
+    std::vector<double> sensor1(samples);
+    for (size_t i = 0; i < samples; i++)
+    {
+        LVM::Row row = SIGNAL.row(i);
+        data.push(row);
+        sensor1[i] = row.sensor1;
+    }
+    std::cout << samples << " samples, window of " << windowSize << " rows, "
+              << threads << " threads" << std::endl;
+
+    measure("mean (WindowSums)", samples, [&]
+    {
+        normalizer::WindowSums sums;
+        double checksum = 0, mean1, mean2;
+        for (size_t i = 0; i < samples; i++)
+        {
+            sums.add(LVM::Row{0, sensor1[i], 0, 0});
+            if (i >= windowSize)
+                sums.remove(LVM::Row{0, sensor1[i - windowSize], 0, 0});
+            sums.means(windowSize, mean1, mean2);
+            checksum += mean1;
+        }
+        return checksum;
+    });
+
+    std::vector<double> exact(samples);
+    measure("median (RollingMedian)", samples, [&]
+    {
+        RollingMedian median(windowSize);
+        double checksum = 0;
+        for (size_t i = 0; i < samples; i++)
+        {
+            median.push(sensor1[i]);
+            exact[i] = median.median();
+            checksum += exact[i];
+        }
+        return checksum;
+    });
+
+    double maxError = 0;
+    measure("histogram (HistogramMedian)", samples, [&]
+    {
+        HistogramMedian median(windowSize);
+        double checksum = 0;
+        for (size_t i = 0; i < samples; i++)
+        {
+            median.push(sensor1[i]);
+            double value = median.median();
+            if (i + 1 >= windowSize)
+                maxError = std::max(maxError, std::fabs(value - exact[i]));
+            checksum += value;
+        }
+        return checksum;
+    });
+
+    for (normalizer::Baseline baseline : {normalizer::Baseline::Mean, normalizer::Baseline::Median,
+                                          normalizer::Baseline::Histogram})
+    {
+        measure(std::string("normalizeWithRolling ") + normalizer::baselineName(baseline),
+                samples, [&]
+        {
+            CLI cli;
+            SampleBuffer normalized(SampleBuffer::Precision::Double);
+            normalizer::normalizeWithRolling(data, normalized, cli, DATA_PER_SECOND, threads,
+                                             scanner::bestKernel(), baseline);
+            int64_t tick;
+            double value1, value2;
+            normalized.read(normalized.size() / 2, 1, &tick, &value1, &value2);
+            return value1;
+        });
+    }
+
+    std::cout << std::scientific << std::setprecision(2)
+              << "Largest |HistogramMedian - RollingMedian|: " << maxError << " V" << std::endl;
+    return 0;
+}
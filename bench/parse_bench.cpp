@@ -0,0 +1,191 @@
+/**
+ * @file parse_bench.cpp
+ * @brief Throughput of the .lvm text parser on a multi-GB file (make bench)
+ *
+ * Writes a synthetic .lvm file (2 GB by default) in the temporary
+ * directory, with rows like those LabVIEW writes: time, ring sensor and
+ * dish sensor with 6 decimals and ',' as the decimal separator. It is then
+ * mapped and read with every kernel the CPU supports, in three ways:
+ * - scan: only the field and line boundaries (FieldScanner)
+ * - parse: boundaries and decimals, on one thread (FieldScanner and
+ *   parseDecimal)
+ * - parseColumns: the parser of drop_finder, in blocks of 4 MB per thread
+ *
+ * and the GB/s of each one are printed. The file is removed at the end.
+ *
+ * Usage: parse_bench [GB] [threads]
+ */
+
+#include "file.hpp"
+#include "scanner.hpp"
+
+namespace
+{
+
+constexpr size_t BLOCK_BYTES = 4 << 20; // Bytes per thread per parseColumns call
+
+/**
+ * @brief Appends a value with 6 decimals and ',' as separator
+ * @param micro Value in millionths
+ */
+void appendDecimal(std::string &line, int64_t micro)
+{
+    if (micro < 0)
+    {
+        line += '-';
+        micro = -micro;
+    }
+    char digits[24];
+    int n = 0;
+    for (int64_t rest = micro; n < 7 || rest > 0; rest /= 10)
+    {
+        digits[n++] = static_cast<char>('0' + rest % 10);
+    }
+    while (n > 6)
+    {
+        line += digits[--n];
+    }
+    line += ',';
+    while (n > 0)
+    {
+        line += digits[--n];
+    }
+}
+
+/**
+ * @brief Writes the synthetic file
+ * @param path Path of the file
+ * @param bytes Size to reach (whole rows are written)
+ */
+void writeSignal(const std::string &path, size_t bytes)
+{
+    std::ofstream file = openFileWrite(path);
+    std::string block;
+    uint64_t state = 42;
+    size_t written = 0;
+    for (int64_t row = 0; written < bytes; row++)
+    {
+        // Sensors around their offsets with a few hundred uV of noise
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        int64_t noise1 = static_cast<int64_t>((state >> 33) % 4000) - 2000;
+        int64_t noise2 = static_cast<int64_t>((state >> 13) % 4000) - 2000;
+        appendDecimal(block, row * 200);
+        block += '\t';
+        appendDecimal(block, 100000 + noise1);
+        block += '\t';
+        appendDecimal(block, -50000 + noise2);
+        block += '\n';
+        if (block.size() >= (1 << 20))
+        {
+            file.write(block.data(), block.size());
+            written += block.size();
+            block.clear();
+        }
+    }
+    file.write(block.data(), block.size());
+    if (!file)
+    {
+        throw std::runtime_error("No se pudo escribir el archivo: " + path);
+    }
+}
+
+/**
+ * @brief Runs one way of reading the file and prints its throughput
+ * @param run Reads the file and returns the rows (or lines) read
+ */
+void measure(const char *kernel, const char *mode, const MappedFile &file,
+             const std::function<size_t()> &run)
+{
+    auto start = std::chrono::steady_clock::now();
+    size_t rows = run();
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::left << std::setw(8) << kernel << std::setw(14) << mode
+              << std::right << std::fixed << std::setprecision(2) << std::setw(7)
+              << file.size() / 1e9 / seconds << " GB/s  " << rows << " rows" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    double gigabytes = argc > 1 ? std::stod(argv[1]) : 2;
+    size_t threads = argc > 2 ? std::stoul(argv[2])
+                              : std::max(1u, std::thread::hardware_concurrency());
+    std::string path =
+        (std::filesystem::temp_directory_path() / "parse_bench.lvm").string();
+
+    try
+    {
+        writeSignal(path, static_cast<size_t>(gigabytes * 1e9));
+        MappedFile file(path);
+        std::string_view contents = file.view();
+        std::cout << "File of " << std::fixed << std::setprecision(2)
+                  << file.size() / 1e9 << " GB, " << threads << " threads" << std::endl;
+
+        std::vector<scanner::Kernel> kernels = {scanner::Kernel::Scalar};
+        if (scanner::bestKernel() != scanner::Kernel::Scalar)
+            kernels.push_back(scanner::Kernel::SSE42);
+        if (scanner::bestKernel() == scanner::Kernel::AVX2)
+            kernels.push_back(scanner::Kernel::AVX2);
+
+        for (scanner::Kernel kernel : kernels)
+        {
+            const char *name = scanner::kernelName(kernel);
+            measure(name, "scan", file, [&]
+            {
+                scanner::FieldScanner fieldScanner(contents, kernel);
+                std::string_view fields[3];
+                size_t rows = 0;
+                while (fieldScanner.nextLine(fields, 3) > 0)
+                    rows++;
+                return rows;
+            });
+            measure(name, "parse", file, [&]
+            {
+                scanner::FieldScanner fieldScanner(contents, kernel);
+                std::string_view fields[3];
+                double value, sum = 0;
+                size_t rows = 0;
+                while (fieldScanner.nextLine(fields, 3) > 0)
+                {
+                    for (const std::string_view &field : fields)
+                    {
+                        if (!scanner::parseDecimal(field, value))
+                            throw std::runtime_error("Numero invalido en la fila " +
+                                                     std::to_string(rows + 1));
+                        sum += value;
+                    }
+                    rows++;
+                }
+                return sum == 0 ? 0 : rows;
+            });
+            measure(name, "parseColumns", file, [&]
+            {
+                size_t rows = 0;
+                for (size_t begin = 0; begin < contents.size();)
+                {
+                    size_t end = contents.find(
+                        '\n', std::min(begin + threads * BLOCK_BYTES, contents.size()) - 1);
+                    end = end == std::string_view::npos ? contents.size() : end + 1;
+                    for (const scanner::Columns &chunk : scanner::parseColumns(
+                             contents.substr(begin, end - begin), threads, kernel,
+                             [](size_t) {}))
+                    {
+                        rows += chunk.size();
+                    }
+                    begin = end;
+                }
+                return rows;
+            });
+        }
+    }
+    catch (const std::exception &error)
+    {
+        std::remove(path.c_str());
+        std::cerr << "Error: " << error.what() << std::endl;
+        return 1;
+    }
+    std::remove(path.c_str());
+    return 0;
+}
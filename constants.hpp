@@ -4,13 +4,14 @@
 // Tamaño maximo de una gota
 constexpr int DROP_SIZE = 400;
 
-// Tamaño de la ventana deslizante para el promedio
+// Tamaño de la ventana deslizante para el promedio (en muestras a
+// DATA_PER_SECOND, se escala con la frecuencia real del archivo)
 constexpr int WINDOW_SIZE = 5000;
 
 // Tamaño de la ventana deslizante para el promedio cuando llenamos huecos
 constexpr int FILL_WINDOW_SIZE = 1000;
 
-// Datos por segundo
+// Datos por segundo (por defecto, si el archivo no trae header de LabVIEW)
 constexpr int DATA_PER_SECOND = 5000;
 
 // Umbral minimo (valor absoluto)
@@ -16,114 +16,526 @@
  */
 
 #include "DropFinder.hpp"
+#include "GlobalDropFinder.hpp"
 #include "Drop.hpp"
+#include "GapFiller.hpp"
 #include "LVM.hpp"
+#include "LVMHeader.hpp"
 #include "constants.hpp"
 #include "normalizer.hpp"
 #include "file.hpp"
 #include "cli.hpp"
+#include "scanner.hpp"
+#include "SampleBuffer.hpp"
+#include "SampleCache.hpp"
+#include "SignalArchive.hpp"
 
 /**
- * @brief Reads sensor data from a file and loads it into the LVM buffer
+ * @brief Command-line options of drop_finder
+ */
+struct Options
+{
+    std::string inputPath;                              // Input .lvm file
+    scanner::Kernel kernel = scanner::bestKernel();     // Text scanning kernel
+    size_t threads = std::max(1u, std::thread::hardware_concurrency()); // Worker threads
+    bool useCache = true;                               // Use/create the .lvmb cache
+    double from = -INFINITY;                            // Start of the time range (.lvma only)
+    double to = INFINITY;                               // End of the time range (.lvma only)
+    bool follow = false;                                // Follow a file being written
+    bool batch = false;                                 // Keep whole signals in memory
+    SampleBuffer::Precision precision = SampleBuffer::defaultPrecision(); // Storage of the signals
+    std::string scratchDirectory;                       // Out of core storage of the signals (--batch)
+    size_t ramBudget = 256 << 20;                       // Bytes of signals kept in RAM out of core
+    normalizer::Baseline baseline = normalizer::Baseline::Mean; // Baseline removed by the normalizer
+    bool globalEngine = false;                          // Pick the drops over the whole signal
+};
+
+// Samples per batch handed over when the input is read (text inputs are
+// read in blocks of TEXT_BLOCK_BYTES per thread instead)
+constexpr size_t BATCH_ROWS = 1 << 16;
+constexpr size_t TEXT_BLOCK_BYTES = 4 << 20;
+
+/**
+ * @brief Receives every batch of samples read from the input, in file order
+ */
+using BatchHandler = std::function<void(const scanner::Columns &)>;
+
+/**
+ * @brief Reports the throughput of the read step
+ * @param cli Reference to CLI for status messages
+ * @param startTime Moment the read step started
+ * @param bytes Bytes of the source file
+ * @param source Description of how the samples were obtained
+ * @param verb What was done with the bytes ("Read", "Processed")
+ */
+void reportRead(CLI &cli, std::chrono::steady_clock::time_point startTime,
+                size_t bytes, const std::string &source, const char *verb = "Read")
+{
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(1) << verb << " "
+            << bytes / 1e6 << " MB in " << std::setprecision(3)
+            << seconds << " s (" << bytes / 1e9 / seconds
+            << " GB/s, " << source << ")";
+    cli.printStatus(message.str());
+}
+
+/**
+ * @brief Reports the acquisition settings the data will be processed with
+ * @param cli Reference to CLI for status messages
+ * @param header Header of the input (sample rate, start, channel names)
+ */
+void reportHeader(CLI &cli, const LVMHeader &header)
+{
+    std::ostringstream message;
+    message << "Acquisition: " << header.dataPerSecond << " samples/s";
+    if (!header.startTimestamp().empty()) {
+      message << ", started " << header.startTimestamp();
+    }
+    for (size_t i = 0; i < header.channelNames.size(); i++) {
+      message << (i == 0 ? ", channels " : ", ") << header.channelNames[i];
+    }
+    cli.printStatus(message.str());
+}
+
+/**
+ * @brief Creates an empty whole-signal buffer
  * 
- * This function uses memory mapping for efficient file reading and parses
- * the data line by line. Each line should contain three values:
- * - time: timestamp of the measurement
- * - sensor1: signal from the ring sensor
- * - sensor2: signal from the dish sensor
+ * Out of core (options.scratchDirectory set) the RAM budget is split
+ * evenly among the buffers that are alive at the same time.
+ * 
+ * @param options Command-line options (sample precision, out of core storage)
+ * @param buffers Number of buffers alive at the same time
+ * @return Buffer in memory or backed by a scratch file
+ */
+SampleBuffer newBuffer(const Options &options, size_t buffers)
+{
+    if (options.scratchDirectory.empty()) {
+      return SampleBuffer(options.precision);
+    }
+    return SampleBuffer(options.precision, options.scratchDirectory,
+                        options.ramBudget / buffers);
+}
+
+/**
+ * @brief Converts the times of parsed samples to ticks
+ * 
+ * Done once per sample, whatever the number of sensor pairs; from then on
+ * the rows only carry the tick (see TimeBase).
+ * 
+ * @param chunk Parsed samples
+ * @param header Header of the input (sample rate and time origin)
+ * @param ticks Output ticks, one per sample
+ */
+void toTicks(const scanner::Columns &chunk, const LVMHeader &header, std::vector<int64_t> &ticks)
+{
+    TimeBase timeBase = header.timeBase();
+    ticks.resize(chunk.size());
+    for (size_t i = 0; i < chunk.size(); i++) {
+      ticks[i] = timeBase.tick(chunk.time[i]);
+    }
+}
+
+/**
+ * @brief Appends parsed samples to one buffer per sensor pair
+ * 
+ * @param pairs Sample buffers, one per sensor pair (created as needed)
+ * @param chunk Next parsed samples, in file order
+ * @param header Header of the input (sample rate and time origin)
+ * @param options Command-line options (sample precision, out of core storage)
+ */
+void addChunk(std::vector<SampleBuffer> &pairs, const scanner::Columns &chunk,
+              const LVMHeader &header, const Options &options)
+{
+    // Each pair is filled and normalized in turn, two more buffers at a time
+    while (pairs.size() < chunk.pairs()) {
+      pairs.push_back(newBuffer(options, chunk.pairs() + 2));
+    }
+    std::vector<int64_t> ticks;
+    toTicks(chunk, header, ticks);
+    for (size_t p = 0; p < chunk.pairs(); p++) {
+      const std::vector<double> &sensor1 = chunk.sensors[2 * p];
+      const std::vector<double> &sensor2 = chunk.sensors[2 * p + 1];
+      for (size_t i = 0; i < chunk.size(); i++) {
+        pairs[p].push(LVM::Row{ticks[i], sensor1[i], sensor2[i], 0});
+      }
+    }
+}
+
+/**
+ * @brief Reads the samples of a valid sidecar cache, BATCH_ROWS at a time
  * 
- * @param lvm Reference to the LVM buffer to store the data
+ * The rows already handed over are dropped from memory, so the cache is
+ * never resident as a whole.
+ * 
+ * @param header Output header, restored from the cache
  * @param cli Reference to CLI for progress reporting
- * @param filePath Path to the input data file
+ * @param cachePath Path to the .lvmb cache
+ * @param sourcePath Path to the source file, to validate the cache
+ * @param file Mapping of the source file, to validate the cache
+ * @param onBatch Receives the samples
+ * @return False if there is no cache or it does not match the source
  */
-void read(LVM &lvm, CLI &cli, const std::string &filePath)
+bool readFromCache(LVMHeader &header, CLI &cli, const std::string &cachePath,
+                   const std::string &sourcePath, const MappedFile &file,
+                   const BatchHandler &onBatch)
 {
-    // Read entire file using memory mapping for efficiency
-    std::string fileContents = readFileContents(filePath);
-    
-    cli.startProgress("read", "Reading data", fileContents.size());
-    size_t currentPosition = 0;
-
-    // Parse the file line by line
-    for(size_t i = 0; i < fileContents.size(); i++) {
-      // Check for end of line or end of file
-      if(fileContents[i] == '\n' || i == fileContents.size() - 1) {
-        // Extract the current line and add to LVM buffer
-        lvm.addSensorData(fileContents.substr(currentPosition, i - currentPosition));
-        currentPosition = i + 1;
-        cli.updateProgress("read", currentPosition);
+    if (!std::filesystem::exists(cachePath)) {
+      return false;
+    }
+
+    try {
+      SampleCache cache(cachePath);
+      if (!cache.isValidFor(sourcePath, file)) {
+        cli.printStatus("Ignoring stale sample cache " + cachePath);
+        return false;
+      }
+
+      std::string_view timestamp = cache.startTimestamp();
+      size_t space = std::min(timestamp.find(' '), timestamp.size());
+      header.dataPerSecond = cache.dataPerSecond();
+      header.date = timestamp.substr(0, space);
+      header.time = timestamp.substr(std::min(space + 1, timestamp.size()));
+      for (size_t channel = 1; channel < cache.channelCount(); channel++) {
+        header.channelNames.emplace_back(cache.channelName(channel));
       }
+
+      cli.startProgress("read", "Reading cache", cache.size());
+      scanner::Columns batch;
+      batch.sensors.resize((cache.channelCount() - 1) / 2 * 2);
+      for (size_t first = 0; first < cache.size(); first += BATCH_ROWS) {
+        size_t rows = std::min(BATCH_ROWS, cache.size() - first);
+        batch.time.assign(cache.column(0) + first, cache.column(0) + first + rows);
+        for (size_t k = 0; k < batch.sensors.size(); k++) {
+          const double *sensor = cache.column(k + 1) + first;
+          batch.sensors[k].assign(sensor, sensor + rows);
+        }
+        cache.release(first, rows);
+        onBatch(batch);
+        cli.updateProgress("read", first + rows);
+      }
+      cli.finishProgress("read");
+      return true;
+    } catch (const std::runtime_error &e) {
+      cli.printError(std::string("Ignoring unreadable sample cache: ") + e.what());
+      return false;
+    }
+}
+
+/**
+ * @brief Decodes the requested time range of a .lvma archive
+ * 
+ * Only the blocks overlapping [options.from, options.to] are decoded, a
+ * few per worker thread at a time. The compression ratio of the archive
+ * is reported.
+ * 
+ * @param header Output header (the archive only keeps the sample rate)
+ * @param cli Reference to CLI for progress reporting
+ * @param options Command-line options (time range, threads)
+ * @param contents Contents of the archive
+ * @param onBatch Receives the decoded samples
+ * @param verb What is done with the samples, for the report
+ */
+void readFromArchive(LVMHeader &header, CLI &cli, const Options &options,
+                     std::string_view contents, const BatchHandler &onBatch,
+                     const char *verb)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    SignalArchive archive(contents);
+    header.dataPerSecond = archive.dataPerSecond();
+
+    cli.startProgress("read", "Decoding archive", archive.size());
+    size_t decoded = 0;
+    archive.decode(options.from, options.to, options.threads,
+                   [&](const scanner::Columns &chunk) {
+                     if (chunk.size() > 0) {
+                       onBatch(chunk);
+                     }
+                     decoded += chunk.size();
+                     cli.updateProgress("read", decoded);
+                   });
+    cli.finishProgress("read");
+
+    std::ostringstream source;
+    source << std::fixed << std::setprecision(2) << "archive, ratio "
+           << archive.compressionRatio() << "x, " << decoded << " of "
+           << archive.size() << " samples";
+    reportRead(cli, startTime, contents.size(), source.str(), verb);
+}
+
+/**
+ * @brief Parses a .gz or .zst input while it is being decompressed
+ * 
+ * A DecompressedStream inflates the file on its own thread; this thread
+ * takes the decompressed chunks as they come, reads the LabVIEW header
+ * from the first ones and parses every run of complete lines right away
+ * (split among the worker threads), keeping only the partial last line
+ * for the next chunk. Nothing is written to disk and only a few chunks of
+ * decompressed text are held in memory; the compressed pages already
+ * inflated are dropped from memory as well.
+ * 
+ * @param header Output header of the input (defaults if it has none)
+ * @param cli Reference to CLI for progress reporting
+ * @param options Command-line options (input file, kernel, threads)
+ * @param file Mapping of the compressed input
+ * @param onBatch Receives the parsed samples
+ * @return Number of decompressed bytes
+ * @throws std::runtime_error if the data is corrupt or truncated
+ * @throws std::invalid_argument if a line is invalid or the number of
+ *         sensor pairs changes
+ */
+size_t readCompressed(LVMHeader &header, CLI &cli, const Options &options,
+                      const MappedFile &file, const BatchHandler &onBatch)
+{
+    std::string_view contents = file.view();
+    DecompressedStream stream(contents, options.inputPath);
+    std::string text;          // Decompressed bytes not parsed yet
+    std::string chunk;
+    size_t lineOffset = 0;     // Lines parsed so far
+    size_t sensorCount = 0;    // Sensor columns, once the first row is parsed
+    size_t released = 0;       // Compressed bytes dropped from memory
+    size_t decompressedBytes = 0;
+    bool headerRead = false;
+    bool finished = false;
+
+    cli.startProgress("read", std::string("Reading ") +
+                      compressionName(stream.compression()) + " data", contents.size());
+    while (!finished) {
+      finished = !stream.next(chunk);
+      text.append(chunk);
+      decompressedBytes += chunk.size();
+
+      // Only complete lines are parsed, the last one waits for the next chunk
+      size_t complete = finished ? text.size() : text.rfind('\n') + 1;
+      std::string_view batch(text.data(), complete);
+
+      if (!headerRead) {
+        header = LVMHeader::parse(batch);
+        // Wait until the header is complete and the first sample follows it
+        headerRead = finished || (!batch.empty() &&
+                                  (!header.present() || header.dataOffset < batch.size()));
+        if (!headerRead) {
+          continue;
+        }
+        lineOffset = header.lineCount;
+        batch.remove_prefix(header.dataOffset);
+      }
+
+      if (!batch.empty()) {
+        std::vector<scanner::Columns> parsed = scanner::parseColumns(
+            batch, options.threads, options.kernel, [](size_t) {}, lineOffset,
+            sensorCount);
+        for (const scanner::Columns &columns : parsed) {
+          if (columns.size() > 0) {
+            sensorCount = columns.sensors.size();
+            onBatch(columns);
+          }
+          lineOffset += columns.lines;
+        }
+      }
+      text.erase(0, complete);
+      file.discard(released, stream.consumed() - released);
+      released = stream.consumed();
+      cli.updateProgress("read", stream.consumed());
+    }
+    cli.finishProgress("read");
+    return decompressedBytes;
+}
+
+/**
+ * @brief Parses a text input, a block of lines at a time
+ * 
+ * The mapping is walked in blocks of TEXT_BLOCK_BYTES per thread, each
+ * snapped forward to the end of a line. Every block is parsed in place by
+ * the vectorized scanner: it is split into one line-aligned byte range per
+ * thread, each thread parses its range into its own column chunk, and the
+ * chunks are handed over in file order, so the result is the same as a
+ * sequential parse. The pages of a block are dropped from memory once it
+ * has been handed over.
+ * 
+ * @param header Output header of the input (defaults if it has none)
+ * @param cli Reference to CLI for progress reporting
+ * @param options Command-line options (kernel, threads)
+ * @param file Mapping of the input
+ * @param onBatch Receives the parsed samples
+ */
+void readText(LVMHeader &header, CLI &cli, const Options &options,
+              const MappedFile &file, const BatchHandler &onBatch)
+{
+    // The header is read in place, the samples start right after it
+    std::string_view contents = file.view();
+    header = LVMHeader::parse(contents);
+
+    size_t lineOffset = header.lineCount; // Lines before the current block
+    size_t sensorCount = 0;               // Sensor columns, once the first row is parsed
+    size_t blockBytes = options.threads * TEXT_BLOCK_BYTES;
+    cli.startProgress("read", "Reading data", contents.size());
+    for (size_t begin = header.dataOffset; begin < contents.size();) {
+      size_t end = contents.find('\n', std::min(begin + blockBytes, contents.size()) - 1);
+      end = end == std::string_view::npos ? contents.size() : end + 1;
+
+      std::vector<scanner::Columns> chunks = scanner::parseColumns(
+          contents.substr(begin, end - begin), options.threads, options.kernel,
+          [&](size_t parsedBytes) {
+            cli.updateProgress("read", begin + parsedBytes);
+          },
+          lineOffset, sensorCount);
+      for (const scanner::Columns &chunk : chunks) {
+        if (chunk.size() > 0) {
+          sensorCount = chunk.sensors.size();
+          onBatch(chunk);
+        }
+        lineOffset += chunk.lines;
+      }
+      file.discard(begin, end - begin);
+      begin = end;
     }
-    
     cli.finishProgress("read");
 }
 
+/**
+ * @brief Reads sensor data from a file, handing it over a batch at a time
+ * 
+ * If a sidecar .lvmb cache built from this exact file exists, the samples
+ * are taken from it and the text is not parsed at all. Otherwise the file
+ * is memory mapped, its LabVIEW header (if any) is read to get the sample
+ * rate, start timestamp and channel names, and the samples that follow it
+ * are parsed block by block (see readText) and written to the cache for
+ * the next run as they are parsed. Each line should contain the time
+ * followed by N sensor pairs (N is taken from the first line):
+ * - time: timestamp of the measurement
+ * - sensor1, sensor2: signals from the ring and dish sensors of each pair
+ * The file is read only once, whatever the number of pairs. Blank lines
+ * are skipped. The ingest throughput is reported at the end.
+ * Inputs that are .lvma archives (detected by their magic bytes) are
+ * decoded instead of parsed, and gzip or zstd compressed inputs (also
+ * detected by their magic bytes, e.g. tormenta.lvm.gz) are parsed while
+ * they are decompressed (see readCompressed).
+ * 
+ * Only the batch being handed over is held in memory: what onBatch keeps
+ * is up to it.
+ * 
+ * @param header Output header of the input (defaults if it has none), set
+ *        before the first batch is handed over, with the time of its first
+ *        sample as the time origin
+ * @param cli Reference to CLI for progress reporting
+ * @param options Command-line options (input file, kernel, threads, cache)
+ * @param onBatch Receives the samples, in file order
+ * @param verb What onBatch does with the samples, for the report
+ * @throws std::invalid_argument if a line has too few fields or a field is
+ *         not a number, or the header cannot be read
+ */
+void read(LVMHeader &header, CLI &cli, const Options &options,
+          const BatchHandler &onBatch, const char *verb)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    // The ticks of every sample count from the first one
+    bool originSet = false;
+    BatchHandler handOver = [&](const scanner::Columns &chunk) {
+      if (!originSet && chunk.size() > 0) {
+        header.timeOrigin = chunk.time[0];
+        originSet = true;
+      }
+      onBatch(chunk);
+    };
+
+    // Map the file, its contents stay valid while `file` is alive
+    MappedFile file(options.inputPath);
+    std::string_view contents = file.view();
+    std::string cachePath = SampleCache::pathFor(options.inputPath);
+
+    if (SignalArchive::isArchive(contents)) {
+      readFromArchive(header, cli, options, contents, handOver, verb);
+      return;
+    }
+    if (options.from != -INFINITY || options.to != INFINITY) {
+      throw std::invalid_argument("--from/--to require a .lvma archive as input");
+    }
+
+    if (options.useCache && readFromCache(header, cli, cachePath, options.inputPath, file, handOver)) {
+      reportRead(cli, startTime, contents.size(), "sample cache " + cachePath, verb);
+      return;
+    }
+
+    // Parsed samples go to the cache as well, until writing it fails
+    std::unique_ptr<SampleCache::Writer> cache;
+    if (options.useCache) {
+      cache = std::make_unique<SampleCache::Writer>(cachePath, options.inputPath, file, header);
+    }
+    auto handle = [&](const scanner::Columns &chunk) {
+      if (cache) {
+        try {
+          cache->add(chunk);
+        } catch (const std::exception &e) {
+          cli.printError(std::string("Could not write sample cache: ") + e.what());
+          cache.reset();
+        }
+      }
+      handOver(chunk);
+    };
+
+    std::string source = std::string(scanner::kernelName(options.kernel)) + " kernel, " +
+                         std::to_string(options.threads) + " thread(s)";
+    if (detectCompression(contents) != Compression::None) {
+      size_t decompressedBytes = readCompressed(header, cli, options, file, handle);
+      std::ostringstream decompressed;
+      decompressed << std::fixed << std::setprecision(1)
+                   << compressionName(detectCompression(contents)) << " stream, "
+                   << decompressedBytes / 1e6 << " MB decompressed, ";
+      source = decompressed.str() + source;
+    } else {
+      readText(header, cli, options, file, handle);
+    }
+    reportRead(cli, startTime, contents.size(), source, verb);
+
+    if (cache) {
+      try {
+        cache->finish();
+        cli.printStatus("Wrote sample cache " + cachePath);
+      } catch (const std::exception &e) {
+        cli.printError(std::string("Could not write sample cache: ") + e.what());
+      }
+    }
+}
+
 /**
  * @brief Fills gaps in the sensor data using linear interpolation
  * 
  * This function detects missing data points (gaps larger than expected time intervals)
  * and fills them using linear interpolation between surrounding data points.
  * The interpolation uses a rolling window to calculate average values on both
- * sides of the gap for more accurate filling.
+ * sides of the gap for more accurate filling (see GapFiller). Every gap
+ * filled is written to the gaps report.
  * 
- * @param lvm Reference to the original LVM data with potential gaps
+ * @param lvm Reference to the original data with potential gaps
+ * @param header Header of the input (sample rate and time origin)
  * @param cli Reference to CLI for progress reporting
- * @param filledLvm Reference to the output LVM that will contain filled data
+ * @param filledLvm Reference to the output buffer that will contain filled data
+ * @param gapsFile Output stream of the gaps report
  */
-void fill(LVM &lvm, CLI &cli, LVM &filledLvm) {
-  size_t halfWindow = FILL_WINDOW_SIZE;
-  double EXPECTED_TIME_DIFF = static_cast<double>(1) / DATA_PER_SECOND;
-  double MAX_TIME_DIFF = 2 * EXPECTED_TIME_DIFF;
+void fill(const SampleBuffer &lvm, const LVMHeader &header, CLI &cli, SampleBuffer &filledLvm,
+          std::ostream &gapsFile) {
+  GapFiller filler{header.timeBase()};
+  std::vector<LVM::Row> filledRows;
 
   cli.startProgress("fill", "Filling data", lvm.size());
 
   for(size_t i = 0; i < lvm.size(); i++) {
-    // Check if there's a gap in the data (time difference too large)
-    if(i > 0 && lvm[i].time - lvm[i - 1].time > MAX_TIME_DIFF) {
-      double diff = lvm[i].time - lvm[i - 1].time;
-      
-      // Calculate how many data points we need to fill the gap
-      size_t numberOfLinesToFill = std::round(diff / EXPECTED_TIME_DIFF) - 1;
-      
-      // Calculate average values from left and right windows around the gap
-      double leftAvgSensor1 = 0, leftAvgSensor2 = 0;
-      double rightAvgSensor1 = 0, rightAvgSensor2 = 0;
-      size_t leftCount = 0, rightCount = 0;
-
-      // Calculate left window average (before the gap)
-      for(size_t j = i < halfWindow ? 0 : i - halfWindow; j < i; j++) {
-        leftAvgSensor1 += lvm[j].sensor1;
-        leftAvgSensor2 += lvm[j].sensor2;
-        leftCount++;
-      }
-
-      // Calculate right window average (after the gap)
-      for(size_t j = i + 1; j < std::min(lvm.size(), i + halfWindow); j++) {
-        rightAvgSensor1 += lvm[j].sensor1;
-        rightAvgSensor2 += lvm[j].sensor2;
-        rightCount++;
-      }
-
-      // Compute the averages
-      leftAvgSensor1 /= leftCount;
-      leftAvgSensor2 /= leftCount;
-      rightAvgSensor1 /= rightCount;
-      rightAvgSensor2 /= rightCount;
-
-      // Fill the gap using linear interpolation
-      for(size_t j = 0; j < numberOfLinesToFill; j++) {
-        double t = lvm[i - 1].time + (j + 1) * EXPECTED_TIME_DIFF;
-        // Linear interpolation between left and right averages
-        double sensor1 = leftAvgSensor1 + (rightAvgSensor1 - leftAvgSensor1) * (t - lvm[i - 1].time) / diff;
-        double sensor2 = leftAvgSensor2 + (rightAvgSensor2 - leftAvgSensor2) * (t - lvm[i - 1].time) / diff;
-        LVM::Row filledRow = LVM::Row{t, sensor1, sensor2, 0};
-        filledLvm.addSensorData(filledRow);
-      }
+    // Rows after a gap are held back until the window after the gap is complete
+    filler.push(lvm[i], filledRows);
+    for(const LVM::Row &row : filledRows) {
+      filledLvm.push(row);
     }
-    // Add the original data point
-    filledLvm.addSensorData(lvm[i]);
+    filledRows.clear();
     cli.updateProgress("fill", i);
   }
+  filler.finish(filledRows);
+  for(const LVM::Row &row : filledRows) {
+    filledLvm.push(row);
+  }
+  filler.writeGaps(gapsFile);
   cli.finishProgress("fill");
 }
 
@@ -134,17 +546,187 @@ void fill(LVM &lvm, CLI &cli, LVM &filledLvm) {
  * variations that can occur in long-term measurements. It uses a rolling window
  * approach to calculate local averages and subtract them from the data.
  * 
- * @param lvm Reference to the input LVM data with potential baseline drift
+ * @param lvm Reference to the input data with potential baseline drift
+ * @param header Header of the input (sample rate)
  * @param cli Reference to CLI for progress reporting
- * @param offsetLvm Reference to the output LVM with normalized data
+ * @param offsetLvm Reference to the output buffer with normalized data
+ * @param threads Number of worker threads (1 out of core, where the
+ *        samples are paged in from a single scratch file)
+ * @param kernel Instruction set of the normalizer kernel
+ * @param baseline Estimator of the baseline
  */
-void remove_offset(LVM &lvm, CLI &cli, LVM &offsetLvm) {
+void remove_offset(const SampleBuffer &lvm, const LVMHeader &header, CLI &cli,
+                   SampleBuffer &offsetLvm, size_t threads, scanner::Kernel kernel,
+                   normalizer::Baseline baseline) {
+  auto startTime = std::chrono::steady_clock::now();
+
   // Normalize the data using rolling window approach
-  std::vector<LVM::Row> normalizedData = normalizer::normalizeWithRolling(lvm.get(), cli);
-  
-  // Copy normalized data to output LVM
-  for(LVM::Row &row : normalizedData) {
-    offsetLvm.addSensorData(row);
+  normalizer::normalizeWithRolling(lvm, offsetLvm, cli, header.dataPerSecond, threads, kernel,
+                                   baseline);
+
+  double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - startTime).count();
+  std::ostringstream message;
+  message << std::fixed << std::setprecision(3) << "Normalized " << lvm.size()
+          << " samples in " << seconds << " s (" << std::setprecision(1)
+          << lvm.size() / 1e6 / seconds << " M samples/s, "
+          << normalizer::baselineName(baseline) << " baseline)";
+  cli.printStatus(message.str());
+}
+
+/**
+ * @brief Receives every valid drop found, in the order they are found
+ */
+using DropHandler = std::function<void(Drop &)>;
+
+/**
+ * @brief Windows searched by findDropsInWindow
+ */
+struct SearchCounts
+{
+  size_t windows = 0; // Full windows with few enough used rows
+  size_t quiet = 0;   // Those skipped because they were quiet
+
+  SearchCounts &operator+=(const SearchCounts &other) {
+    windows += other.windows;
+    quiet += other.quiet;
+    return *this;
+  }
+};
+
+/**
+ * @brief Reports how many windows the drop search skipped as quiet
+ * @param cli Reference to CLI for status messages
+ * @param counts Windows searched
+ * @param seconds Time taken by the search, 0 if not measured
+ */
+void reportSearch(CLI &cli, const SearchCounts &counts, double seconds = 0) {
+  std::ostringstream message;
+  message << std::fixed << std::setprecision(1) << "Skipped " << counts.quiet << " of "
+          << counts.windows << " windows as quiet ("
+          << (counts.windows ? 100.0 * counts.quiet / counts.windows : 0.0) << "%)";
+  if (seconds > 0) {
+    message << std::setprecision(3) << ", drops found in " << seconds << " s";
+  }
+  cli.printStatus(message.str());
+}
+
+/**
+ * @brief Detects the drops of the current sliding window
+ * 
+ * Does nothing until the window holds 2*DROP_SIZE points, or when too much
+ * of it is already marked as used. Otherwise every drop found in the window
+ * is validated, marked as used and handed over; then the first half of the
+ * window is marked as used so it is not searched again. A quiet window
+ * (see DropWindow::quiet) has no drop to find, so it goes straight to the
+ * last step.
+ * 
+ * @param findWindow Sliding window buffer, its last point was just added
+ * @param dropFinder Drop detector
+ * @param position Index in the normalized signal of the last point of the window
+ * @param counts Windows searched, updated
+ * @param onDrop Receives each valid drop, with its data offset set (not its id)
+ */
+void findDropsInWindow(DropWindow &findWindow, DropFinder &dropFinder, size_t position,
+                       SearchCounts &counts, const DropHandler &onDrop) {
+  // Process when we have enough data in the window (2*DROP_SIZE)
+  if(findWindow.size() != DROP_SIZE * 2) {
+    return;
+  }
+  // Skip if too much data is already marked as used
+  if(findWindow.totalUsed() > NN) {
+    return;
+  }
+  counts.windows++;
+  if(findWindow.quiet()) {
+    counts.quiet++;
+    findWindow.setUsed(0, DROP_SIZE - 1);
+    return;
+  }
+
+  Drop drop;
+  do {
+    // Try to find a drop in the current window
+    drop = dropFinder.findDrop(findWindow);
+    
+    if(drop.c1 == -1) {
+      // No peak found, exit the detection loop
+      break;
+    }
+    
+    if(!drop.valid) {
+      // Drop found but failed validation - mark peaks as used to avoid re-detection
+      findWindow.setUsed(drop.u1Original + drop.c1, drop.u1Original + drop.c1 + 1);
+      findWindow.setUsed(drop.u1Original + drop.c2, drop.u1Original + drop.c2 + 1);
+      continue;
+    }
+    
+    // Valid drop found - mark the entire drop region as used
+    findWindow.setUsed(drop.u1Original, drop.u1Original + drop.size() - 1);
+    drop.dataOffset = static_cast<int>(position - findWindow.size() + 1 + drop.u1Original);
+    onDrop(drop);
+  } while(true);
+
+  // Mark the first half of the window as used to advance the sliding window
+  findWindow.setUsed(0, DROP_SIZE - 1);
+}
+
+// Rows of the normalized signal searched by each thread of find_drops at a
+// time, and rows at the start of a segment where the search of the segment
+// before it may meet its own (see find_drops)
+constexpr size_t SEGMENT_ROWS = 1 << 18;
+constexpr size_t SYNC_ROWS = 1 << 15;
+
+/**
+ * @brief Sliding window search over one segment of the normalized signal
+ * 
+ * Besides the drops, it keeps the used flags of its window after each of
+ * the first SYNC_ROWS rows of the segment, which find_drops compares with
+ * those of the search of the segment before.
+ */
+struct Segment
+{
+  size_t begin;          // First row of the segment
+  size_t end;            // Row after the last one searched
+  size_t firstKept;      // First row whose drops are those of the serial search
+  DropWindow findWindow; // Sliding window for drop detection
+  DropFinder dropFinder; // Drop detector
+  std::vector<std::pair<size_t, Drop>> drops; // Drops found, with the row found at
+  std::vector<uint64_t> head; // Used flags after each row, DropWindow::FLAG_WORDS per row
+  SearchCounts counts;                  // Windows searched
+  std::vector<SearchCounts> headCounts; // Windows searched up to each row of head
+
+  Segment(size_t begin, const TimeBase &timeBase)
+      : begin(begin), end(begin), firstKept(begin), dropFinder(timeBase) {}
+};
+
+/**
+ * @brief Searches the next rows of a segment
+ * @param lvm Reference to the normalized sensor data
+ * @param segment Segment whose window the rows are added to
+ * @param to Row after the last one to search (from segment.end on)
+ * @param afterRow Called after each row with its index; the search stops
+ *        after the row when it returns false
+ */
+void searchSegment(const SampleBuffer &lvm, Segment &segment, size_t to,
+                   const std::function<bool(size_t)> &afterRow) {
+  std::vector<int64_t> ticks(BATCH_ROWS);
+  std::vector<double> sensor1(BATCH_ROWS), sensor2(BATCH_ROWS);
+  while(segment.end < to) {
+    size_t first = segment.end;
+    size_t count = std::min(BATCH_ROWS, to - first);
+    lvm.read(first, count, ticks.data(), sensor1.data(), sensor2.data());
+    for(size_t k = 0; k < count; k++) {
+      size_t i = first + k;
+      segment.findWindow.addSensorData(LVM::Row{ticks[k], sensor1[k], sensor2[k], 0});
+      findDropsInWindow(segment.findWindow, segment.dropFinder, i, segment.counts, [&](Drop &drop) {
+        segment.drops.emplace_back(i, std::move(drop));
+      });
+      segment.end = i + 1;
+      if(!afterRow(i)) {
+        return;
+      }
+    }
   }
 }
 
@@ -163,107 +745,753 @@ void remove_offset(LVM &lvm, CLI &cli, LVM &offsetLvm) {
  * 4. Marks used data points to avoid double-counting
  * 5. Writes valid drops to the output file
  * 
+ * The signal is searched in segments of SEGMENT_ROWS rows, one per thread
+ * at a time, each with a window of its own that starts 2*DROP_SIZE rows
+ * before the segment so it is full at its first row. The search of a
+ * window only depends on its rows and used flags, so once the flags of a
+ * segment match those the search of the segment before would have after
+ * the same row, both find the same drops from then on. The search of the
+ * segment before therefore goes on into the segment, one row at a time,
+ * until its flags match (usually within a few thousand rows); its drops
+ * are kept up to there and those of the segment from the next row. If the
+ * flags do not match within SYNC_ROWS rows, it goes on through the whole
+ * segment instead. The drops, and their ids, are the same as those of a
+ * single search whatever the number of threads.
+ * 
  * @param lvm Reference to the normalized sensor data
+ * @param header Header of the input (sample rate and time origin)
  * @param cli Reference to CLI for progress reporting
- * @param findLvm Reference to the sliding window buffer for drop detection
  * @param outFile Reference to the output file stream for writing results
+ * @param threads Number of worker threads
  */
-void find_drops(LVM &lvm, CLI &cli, LVM &findLvm, std::ofstream &outFile) {
+void find_drops(const SampleBuffer &lvm, const LVMHeader &header, CLI &cli,
+                std::ofstream &outFile, size_t threads) {
   cli.startProgress("find_drops", "Finding drops", lvm.size());
-  DropFinder dropFinder;
+  constexpr size_t WORDS = DropWindow::FLAG_WORDS;
+  size_t rows = lvm.size();
+  size_t segments = std::max<size_t>(1, (rows + SEGMENT_ROWS - 1) / SEGMENT_ROWS);
   size_t gotas = 0; // Counter for detected drops
-  
-  for(size_t i = 0; i < lvm.size(); i++) {
-    // Add current data point to the sliding window
-    findLvm.addSensorData(lvm[i]);
-    cli.updateProgress("find_drops", i);
-    
-    // Process when we have enough data in the window (2*DROP_SIZE)
-    if(findLvm.size() == DROP_SIZE * 2) {
-      // Skip if too much data is already marked as used
-      if(findLvm.totalUsed > NN) {
-        continue;
+  SearchCounts counts; // Windows of the serial search
+  auto startTime = std::chrono::steady_clock::now();
+
+  // Writes the drops of the serial search found by a segment up to a row
+  auto write = [&](Segment &segment, size_t last) {
+    for(auto &[row, drop] : segment.drops) {
+      if(row >= segment.firstKept && row <= last) {
+        drop.id = ++gotas; // Assign unique ID
+        drop.writeToFile(outFile);
       }
-      
-      Drop drop;
-      do {
-        // Try to find a drop in the current window
-        drop = dropFinder.findDrop(findLvm);
-        
-        if(drop.c1 == -1) {
-          // No peak found, exit the detection loop
-          break;
-        }
-        
-        if(!drop.valid) {
-          // Drop found but failed validation - mark peaks as used to avoid re-detection
-          findLvm.setUsed(drop.u1Original + drop.c1, drop.u1Original + drop.c1 + 1);
-          findLvm.setUsed(drop.u1Original + drop.c2, drop.u1Original + drop.c2 + 1);
-          continue;
+    }
+    segment.drops.clear();
+  };
+  auto all = [](size_t) { return true; };
+
+  std::unique_ptr<Segment> serial; // Segment whose search is the serial one so far
+  for(size_t round = 0; round < segments; round += threads) {
+    size_t active = std::min(threads, segments - round);
+    std::vector<std::unique_ptr<Segment>> batch(active);
+    auto work = [&](size_t t) {
+      size_t begin = (round + t) * SEGMENT_ROWS;
+      size_t end = std::min(rows, begin + SEGMENT_ROWS);
+      if(threads == 1 && serial) {
+        // A single thread has nothing to gain from restarting the search
+        searchSegment(lvm, *serial, end, all);
+        return;
+      }
+      Segment &segment = *(batch[t] = std::make_unique<Segment>(begin, header.timeBase()));
+      segment.end = begin > 0 ? begin - 2 * DROP_SIZE : 0;
+      searchSegment(lvm, segment, end, [&](size_t i) {
+        if(begin > 0 && i >= begin && i < begin + SYNC_ROWS) {
+          segment.head.resize(segment.head.size() + WORDS);
+          segment.findWindow.usedFlags(segment.head.data() + segment.head.size() - WORDS);
+          segment.headCounts.push_back(segment.counts);
         }
-        
-        // Valid drop found - mark the entire drop region as used
-        findLvm.setUsed(drop.u1Original, drop.u1Original + drop.size() - 1);
-        drop.id = ++gotas; // Assign unique ID
-        drop.dataOffset = static_cast<int>(i - findLvm.size() + 1 + drop.u1Original);
-        drop.writeToFile(outFile); // Write to output file
-      } while(true);
+        return true;
+      });
+    };
+    std::vector<std::thread> workers;
+    for(size_t t = 1; t < active; t++) {
+      workers.emplace_back(work, t);
+    }
+    work(0);
+    for(std::thread &worker : workers) {
+      worker.join();
+    }
 
-      // Mark the first half of the window as used to advance the sliding window
-      findLvm.setUsed(0, DROP_SIZE - 1);
+    for(std::unique_ptr<Segment> &segment : batch) {
+      if(!segment) {
+        continue;
+      }
+      if(!serial) {
+        serial = std::move(segment);
+        continue;
+      }
+      // Go on with the serial search until its used flags match
+      bool met = false;
+      uint64_t flags[WORDS];
+      searchSegment(lvm, *serial, segment->begin + segment->head.size() / WORDS, [&](size_t i) {
+        serial->findWindow.usedFlags(flags);
+        met = std::equal(flags, flags + WORDS,
+                         segment->head.data() + (i - segment->begin) * WORDS);
+        return !met;
+      });
+      if(met) {
+        // The segment counts the windows of the serial search from there
+        const SearchCounts &before = segment->headCounts[serial->end - 1 - segment->begin];
+        segment->counts.windows -= before.windows;
+        segment->counts.quiet -= before.quiet;
+        write(*serial, serial->end - 1);
+        counts += serial->counts;
+        segment->firstKept = serial->end;
+        serial = std::move(segment);
+      } else {
+        write(*serial, rows);
+        searchSegment(lvm, *serial, segment->end, all);
+      }
     }
+    write(*serial, serial->end - 1);
+    cli.updateProgress("find_drops", serial->end);
   }
   cli.finishProgress("find_drops");
+  counts += serial->counts;
+  reportSearch(cli, counts,
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
 }
 
 /**
- * @brief Main processing pipeline for drop detection and analysis
+ * @brief Detects the drops of the whole normalized signal at once (--engine=global)
+ * 
+ * Instead of searching a sliding window, GlobalDropFinder computes the
+ * candidates of every row in one pass and picks the drops strongest first
+ * over the whole signal (see GlobalDropFinder); the drops are then analyzed
+ * again and written one at a time, in time order.
  * 
- * This function orchestrates the complete drop detection pipeline:
- * 1. Read raw sensor data from file
+ * @param lvm Reference to the normalized sensor data
+ * @param header Header of the input (sample rate and time origin)
+ * @param cli Reference to CLI for progress reporting
+ * @param outFile Reference to the output file stream for writing results
+ */
+void find_drops_global(const SampleBuffer &lvm, const LVMHeader &header, CLI &cli,
+                       std::ofstream &outFile) {
+  GlobalDropFinder dropFinder(header.timeBase());
+  dropFinder.findDrops(lvm, cli, [&](Drop &drop) { drop.writeToFile(outFile); });
+}
+
+/**
+ * @brief Returns the output path of one sensor pair
+ * 
+ * A file with a single pair writes to outPath itself; with several pairs,
+ * pair k writes to outPath with "_k" inserted before the extension
+ * (drops.dat -> drops_1.dat, drops_2.dat, ...).
+ * 
+ * @param outPath Output path of a single pair file
+ * @param pair 0-based pair number
+ * @param pairCount Number of pairs in the file
+ * @return Output path of the pair
+ */
+std::string pairOutputPath(const std::string &outPath, size_t pair, size_t pairCount)
+{
+    if (pairCount == 1) {
+      return outPath;
+    }
+    std::filesystem::path path(outPath);
+    std::string extension = path.extension().string();
+    return path.replace_extension().string() + "_" + std::to_string(pair + 1) + extension;
+}
+
+/**
+ * @brief Returns the gaps report path of one sensor pair
+ * 
+ * gaps.dat next to the output file, numbered per pair like it
+ * (gaps_1.dat, gaps_2.dat, ...).
+ * 
+ * @param outPath Output path of a single pair file
+ * @param pair 0-based pair number
+ * @param pairCount Number of pairs in the file
+ * @return Gaps report path of the pair
+ */
+std::string pairGapsPath(const std::string &outPath, size_t pair, size_t pairCount)
+{
+    std::filesystem::path path(outPath);
+    return pairOutputPath(path.replace_filename("gaps.dat").string(), pair, pairCount);
+}
+
+/**
+ * @brief Streaming pipeline of one sensor pair
+ * 
+ * Rows go through the fill, normalize and find stages as soon as they are
+ * read. Each stage keeps only the state it needs (the rows around the last
+ * gap, the normalization window and the drop search window), so memory
+ * does not grow with the length of the signal, and the drops written are
+ * the same as those of the whole-signal steps (fill, remove_offset,
+ * find_drops).
+ */
+struct PairPipeline
+{
+    GapFiller filler;                         // Gap filling stage
+    normalizer::RollingNormalizer normalizer; // Baseline removal stage
+    DropWindow findWindow;                    // Sliding window for drop detection
+    DropFinder dropFinder;                    // Drop detector
+    size_t position;                          // Normalized rows seen so far
+    size_t gotas;                             // Drops written so far
+    SearchCounts counts;                      // Windows searched so far
+    std::ofstream outFile;                    // Output file of the pair
+    std::ofstream gapsFile;                   // Gaps report of the pair
+    std::vector<LVM::Row> filledRows;         // Rows released by the gap filler
+
+    PairPipeline(const LVMHeader &header, const std::string &outPath,
+                 const std::string &gapsPath, normalizer::Baseline baseline)
+        : filler(header.timeBase()), normalizer(header.dataPerSecond, baseline),
+          dropFinder(header.timeBase()),
+          position(0), gotas(0), outFile(openFileWrite(outPath)),
+          gapsFile(openFileWrite(gapsPath)) {}
+
+    /**
+     * @brief Pushes the next row of the signal through every stage
+     * @param row Next row read, in time order
+     */
+    void push(const LVM::Row &row)
+    {
+        filler.push(row, filledRows);
+        process();
+    }
+
+    /**
+     * @brief Processes the rows still held back at the end of the signal
+     */
+    void finish()
+    {
+        filler.finish(filledRows);
+        process();
+        flush();
+    }
+
+    /**
+     * @brief Writes out the drops and gaps found so far
+     */
+    void flush()
+    {
+        outFile.flush();
+        gapsFile.flush();
+    }
+
+private:
+    /**
+     * @brief Runs the filled rows through normalization and drop detection
+     */
+    void process()
+    {
+        filler.writeGaps(gapsFile);
+        LVM::Row normalizedRow;
+        for (const LVM::Row &row : filledRows) {
+          if (normalizer.push(row, normalizedRow)) {
+            findWindow.addSensorData(normalizedRow);
+            findDropsInWindow(findWindow, dropFinder, position++, counts, [this](Drop &drop) {
+              drop.id = ++gotas; // Assign unique ID
+              drop.writeToFile(outFile);
+            });
+          }
+        }
+        filledRows.clear();
+    }
+};
+
+/**
+ * @brief Reports the sensor pair a pipeline processes, when there are several
+ * @param cli Reference to CLI for status messages
+ * @param header Header of the input (channel names)
+ * @param pair 0-based pair number
+ * @param pairCount Number of pairs in the file
+ * @param pairPath Output path of the pair
+ */
+void reportPair(CLI &cli, const LVMHeader &header, size_t pair, size_t pairCount,
+                const std::string &pairPath)
+{
+    if (pairCount > 1) {
+      cli.printStatus("Sensor pair " + std::to_string(pair + 1) + " of " +
+                      std::to_string(pairCount) + " (" +
+                      header.channelName(2 * pair) + ", " +
+                      header.channelName(2 * pair + 1) + ") -> " + pairPath);
+    }
+}
+
+/**
+ * @brief Reports the page faults of the process since a starting point
+ * @param cli Reference to CLI for status messages
+ * @param startTime Moment the counting started
+ * @param start Resource usage at that moment
+ * @param scratchBytes Bytes written to scratch files
+ */
+void reportPageFaults(CLI &cli, std::chrono::steady_clock::time_point startTime,
+                      const rusage &start, size_t scratchBytes)
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+    long major = usage.ru_majflt - start.ru_majflt;
+    long minor = usage.ru_minflt - start.ru_minflt;
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(0) << "Page faults: " << major
+            << " major (" << major / seconds << "/s), " << minor << " minor ("
+            << minor / seconds << "/s), " << std::setprecision(1)
+            << scratchBytes / 1e6 << " MB through scratch files";
+    cli.printStatus(message.str());
+}
+
+/**
+ * @brief Whole-signal processing pipeline (--batch)
+ * 
+ * 1. Read raw sensor data from file (once, for every sensor pair)
  * 2. Fill gaps in the data using interpolation
  * 3. Normalize data to remove baseline drift
  * 4. Detect and analyze individual drops
  * 5. Write results to output file
+ * Steps 2 to 5 run for each sensor pair in turn, each pair writing its own
+ * output file (see pairOutputPath).
  * 
- * The function manages memory efficiently by clearing intermediate buffers
- * after each processing step to minimize memory usage.
+ * Every step keeps the whole signal, in the storage chosen with --samples;
+ * intermediate buffers are cleared after each step to minimize memory
+ * usage. With --out-of-core the signals are kept in scratch files instead
+ * of RAM, only options.ramBudget bytes of them staying resident, and the
+ * page faults taken are reported at the end.
  * 
- * @param filePath Path to the input sensor data file
+ * @param options Command-line options (input file, kernel, ...)
  * @param outPath Path to the output file for drop analysis results
  */
-void perform(const std::string &filePath, const std::string &outPath)
+void performBatch(const Options &options, const std::string &outPath)
 {
     CLI cli;
+    auto startTime = std::chrono::steady_clock::now();
+    rusage startUsage;
+    getrusage(RUSAGE_SELF, &startUsage);
     
-    // Initialize LVM buffers for different processing stages
-    LVM lvm(size_t(-1));           // Original data buffer (unlimited size)
-    LVM filledLvm(size_t(-1));     // Data with gaps filled (unlimited size)
-    LVM offsetLvm(size_t(-1));     // Normalized data (unlimited size)
-    LVM findLvm(2 * DROP_SIZE);    // Sliding window for drop detection (fixed size)
-    
-    // Step 1: Read raw sensor data from file
-    read(lvm, cli, filePath);
+    // Step 1: Read raw sensor data from file, one buffer per sensor pair
+    std::vector<SampleBuffer> pairs;
+    LVMHeader header;
+    read(header, cli, options,
+         [&](const scanner::Columns &chunk) { addChunk(pairs, chunk, header, options); },
+         "Read");
+    if (pairs.empty()) {
+      pairs.push_back(newBuffer(options, 3));
+    }
+    reportHeader(cli, header);
+
+    size_t samples = 0, bytes = 0;
+    for (const SampleBuffer &pair : pairs) {
+      samples += pair.size();
+      bytes += pair.bytes();
+    }
+    std::ostringstream memory;
+    memory << std::fixed << std::setprecision(1) << "Samples: " << samples << " in "
+           << bytes / 1e6 << " MB (" << SampleBuffer::precisionName(options.precision)
+           << " sensors, " << (samples ? double(bytes) / samples : 0.0) << " bytes/sample)";
+    if (!options.scratchDirectory.empty()) {
+      memory << ", out of core in " << options.scratchDirectory << " with a RAM budget of "
+             << options.ramBudget / 1e6 << " MB";
+    }
+    cli.printStatus(memory.str());
+    size_t scratchBytes = 0;
+
+    for (size_t p = 0; p < pairs.size(); p++) {
+      std::string pairPath = pairOutputPath(outPath, p, pairs.size());
+      reportPair(cli, header, p, pairs.size(), pairPath);
+
+      // Initialize buffers for different processing stages
+      size_t buffers = pairs.size() + 2;
+      SampleBuffer &lvm = pairs[p];                                  // Original data
+      SampleBuffer filledLvm = newBuffer(options, buffers);          // Data with gaps filled
+      SampleBuffer offsetLvm = newBuffer(options, buffers);          // Normalized data
+
+      // Step 2: Fill gaps in the data using interpolation
+      auto gapsFile = openFileWrite(pairGapsPath(outPath, p, pairs.size()));
+      fill(lvm, header, cli, filledLvm, gapsFile);
+      scratchBytes += lvm.scratchBytes();
+      lvm.clear(); // Free memory from original data
+
+      // Step 3: Normalize data to remove baseline drift
+      remove_offset(filledLvm, header, cli, offsetLvm,
+                    options.scratchDirectory.empty() ? options.threads : 1, options.kernel,
+                    options.baseline);
+      scratchBytes += filledLvm.scratchBytes();
+      filledLvm.clear(); // Free memory from filled data
+
+      // Step 4: Detect drops and write results
+      auto outFile = openFileWrite(pairPath);
+      if (options.globalEngine) {
+        find_drops_global(offsetLvm, header, cli, outFile);
+      } else {
+        find_drops(offsetLvm, header, cli, outFile,
+                   options.scratchDirectory.empty() ? options.threads : 1);
+      }
+      scratchBytes += offsetLvm.scratchBytes();
+    }
+
+    if (!options.scratchDirectory.empty()) {
+      reportPageFaults(cli, startTime, startUsage, scratchBytes);
+    }
+}
+
+/**
+ * @brief Main processing pipeline for drop detection and analysis
+ * 
+ * Reads the input once and pushes every batch of samples through one
+ * PairPipeline per sensor pair (fill gaps, normalize, detect and analyze
+ * drops, write them), each pair writing its own output file (see
+ * pairOutputPath). Nothing but the current batch and the windows of the
+ * pipelines is held in memory, so a storm of any length runs in the same
+ * memory; the drops written are the same as with --batch (see
+ * performBatch).
+ * 
+ * @param options Command-line options (input file, kernel, ...)
+ * @param outPath Path to the output file for drop analysis results
+ */
+void perform(const Options &options, const std::string &outPath)
+{
+    if (options.batch) {
+      performBatch(options, outPath);
+      return;
+    }
 
-    // Step 2: Fill gaps in the data using interpolation
-    fill(lvm, cli, filledLvm);
-    lvm.clear(); // Free memory from original data
+    CLI cli;
+    LVMHeader header;
+    std::vector<std::unique_ptr<PairPipeline>> pairs;
+    size_t samples = 0;
+    std::vector<int64_t> ticks;
+    read(header, cli, options, [&](const scanner::Columns &chunk) {
+      // The first batch tells how many pairs there are
+      if (pairs.empty()) {
+        for (size_t p = 0; p < chunk.pairs(); p++) {
+          std::string pairPath = pairOutputPath(outPath, p, chunk.pairs());
+          reportPair(cli, header, p, chunk.pairs(), pairPath);
+          pairs.push_back(std::make_unique<PairPipeline>(
+              header, pairPath, pairGapsPath(outPath, p, chunk.pairs()), options.baseline));
+        }
+      }
+      toTicks(chunk, header, ticks);
+      for (size_t p = 0; p < pairs.size(); p++) {
+        const std::vector<double> &sensor1 = chunk.sensors[2 * p];
+        const std::vector<double> &sensor2 = chunk.sensors[2 * p + 1];
+        for (size_t i = 0; i < chunk.size(); i++) {
+          pairs[p]->push(LVM::Row{ticks[i], sensor1[i], sensor2[i], 0});
+        }
+      }
+      samples += chunk.size();
+    }, "Processed");
+    if (pairs.empty()) {
+      pairs.push_back(std::make_unique<PairPipeline>(header, outPath,
+                                                     pairGapsPath(outPath, 0, 1),
+                                                     options.baseline));
+    }
+    reportHeader(cli, header);
+
+    // Release the rows held back by the gap fillers
+    size_t drops = 0;
+    SearchCounts counts;
+    for (const auto &pair : pairs) {
+      pair->finish();
+      drops += pair->gotas;
+      counts += pair->counts;
+    }
+    cli.printStatus("Samples: " + std::to_string(samples) + ", " +
+                    std::to_string(drops) + " drops (streamed)");
+    reportSearch(cli, counts);
+}
+
+// Set by SIGINT/SIGTERM to end --follow mode
+volatile std::sig_atomic_t stopFollowing = 0;
 
-    // Step 3: Normalize data to remove baseline drift
-    remove_offset(filledLvm, cli, offsetLvm);
-    filledLvm.clear(); // Free memory from filled data
+/**
+ * @brief Follows an acquisition file while it is being written
+ * 
+ * The rows already in the file are processed right away, then the file is
+ * watched with inotify and every new complete line is pushed through the
+ * incremental fill, normalize and find stages of its sensor pair. Output
+ * files are flushed after every batch of new lines, so a drop reaches its
+ * drops file at most about FILL_WINDOW_SIZE + WINDOW_SIZE / 2 + 2 * DROP_SIZE
+ * samples after its last sample (plus the time LabVIEW takes to write
+ * them). Following ends on Ctrl+C/SIGTERM or when the file is deleted or
+ * renamed; the rows still held back are then processed.
+ * 
+ * With --baseline=ema the normalization is causal, so the WINDOW_SIZE / 2
+ * rows ahead are not waited for.
+ * 
+ * @param options Command-line options (input file, kernel)
+ * @param outPath Path to the output file for drop analysis results
+ * @throws std::runtime_error if the file cannot be read or watched
+ * @throws std::invalid_argument if a line is invalid or the number of
+ *         sensor pairs changes
+ */
+void follow(const Options &options, const std::string &outPath)
+{
+    CLI cli;
+
+    // Descriptors are closed on every way out of this function
+    struct Descriptor
+    {
+        int fd;
+        ~Descriptor() { if (fd >= 0) close(fd); }
+    };
+    Descriptor file{open(options.inputPath.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (file.fd < 0) {
+      throw std::runtime_error("No se pudo abrir el archivo: " + options.inputPath);
+    }
+    Descriptor watch{inotify_init1(IN_NONBLOCK | IN_CLOEXEC)};
+    if (watch.fd < 0 || inotify_add_watch(watch.fd, options.inputPath.c_str(),
+                                          IN_MODIFY | IN_CLOSE_WRITE |
+                                          IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+      throw std::runtime_error("No se pudo vigilar el archivo: " + options.inputPath);
+    }
+
+    std::signal(SIGINT, [](int) { stopFollowing = 1; });
+    std::signal(SIGTERM, [](int) { stopFollowing = 1; });
+    cli.printStatus("Following " + options.inputPath + " (Ctrl+C to stop)");
+
+    std::string text;          // Bytes read and not processed yet
+    size_t lineOffset = 0;     // Lines processed so far
+    size_t sensorCount = 0;    // Sensor columns, once the first row is parsed
+    bool headerRead = false;
+    LVMHeader header;
+    std::vector<std::unique_ptr<PairPipeline>> pairs;
+    std::vector<int64_t> ticks;
+    size_t samples = 0, reportedDrops = 0;
+    auto lastReport = std::chrono::steady_clock::now();
+    char buffer[1 << 16];
+    bool finished = false;
+
+    while (!finished) {
+      // Read everything appended since the last time
+      ssize_t bytes;
+      while ((bytes = ::read(file.fd, buffer, sizeof(buffer))) > 0) {
+        text.append(buffer, bytes);
+      }
+      if (bytes < 0 && errno != EINTR) {
+        throw std::runtime_error("No se pudo leer el archivo: " + options.inputPath);
+      }
+      finished = stopFollowing;
+
+      // Only complete lines are processed, unless following has ended
+      size_t complete = finished ? text.size() : text.rfind('\n') + 1;
+      std::string_view contents(text.data(), complete);
+
+      if (!headerRead) {
+        if (SignalArchive::isArchive(contents) ||
+            detectCompression(contents) != Compression::None) {
+          throw std::invalid_argument("--follow requires a text .lvm file");
+        }
+        header = LVMHeader::parse(contents);
+        // Wait until the header is complete and the first sample follows it
+        headerRead = finished || (!contents.empty() &&
+                                  (!header.present() || header.dataOffset < contents.size()));
+        if (headerRead) {
+          reportHeader(cli, header);
+          text.erase(0, header.dataOffset);
+          complete -= header.dataOffset;
+          contents = std::string_view(text.data(), complete);
+          lineOffset = header.lineCount;
+        }
+      }
+
+      if (headerRead && !contents.empty()) {
+        std::vector<scanner::Columns> chunks = scanner::parseColumns(
+            contents, 1, options.kernel, [](size_t) {}, lineOffset, sensorCount);
+        const scanner::Columns &chunk = chunks[0];
+        if (chunk.size() > 0 && pairs.empty()) {
+          // The ticks of every sample count from the first one
+          header.timeOrigin = chunk.time[0];
+          sensorCount = chunk.sensors.size();
+          for (size_t p = 0; p < chunk.pairs(); p++) {
+            pairs.push_back(std::make_unique<PairPipeline>(
+                header, pairOutputPath(outPath, p, chunk.pairs()),
+                pairGapsPath(outPath, p, chunk.pairs()), options.baseline));
+          }
+        }
+
+        toTicks(chunk, header, ticks);
+        for (size_t p = 0; p < pairs.size(); p++) {
+          for (size_t i = 0; i < chunk.size(); i++) {
+            LVM::Row row = {ticks[i], chunk.sensors[2 * p][i], chunk.sensors[2 * p + 1][i], 0};
+            pairs[p]->push(row);
+          }
+          pairs[p]->flush();
+        }
+        samples += chunk.size();
+        lineOffset += std::count(contents.begin(), contents.end(), '\n');
+        text.erase(0, complete);
+      }
 
-    // Step 4: Detect drops and write results
-    auto outFile = openFileWrite(outPath);
-    find_drops(offsetLvm, cli, findLvm, outFile);
+      // Report the drops found so far, at most every few seconds
+      size_t drops = 0;
+      for (const auto &pair : pairs) {
+        drops += pair->gotas;
+      }
+      if (drops != reportedDrops &&
+          std::chrono::steady_clock::now() - lastReport > std::chrono::seconds(5)) {
+        cli.printStatus(std::to_string(drops) + " drops in " +
+                        std::to_string(samples) + " samples");
+        reportedDrops = drops;
+        lastReport = std::chrono::steady_clock::now();
+      }
+
+      // Wait for the file to change (or poll again after a while)
+      pollfd event = {watch.fd, POLLIN, 0};
+      if (!finished && poll(&event, 1, 1000) > 0) {
+        alignas(inotify_event) char events[4096];
+        ssize_t length;
+        while ((length = ::read(watch.fd, events, sizeof(events))) > 0) {
+          for (char *e = events; e < events + length;) {
+            const inotify_event *notification = reinterpret_cast<inotify_event *>(e);
+            if (notification->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+              stopFollowing = 1;
+            }
+            e += sizeof(inotify_event) + notification->len;
+          }
+        }
+      }
+    }
+
+    // Release the rows held back by the gap fillers
+    size_t drops = 0;
+    for (const auto &pair : pairs) {
+      pair->finish();
+      drops += pair->gotas;
+    }
+    cli.printSuccess("Stopped following after " + std::to_string(samples) +
+                     " samples, " + std::to_string(drops) + " drops");
+}
+
+/**
+ * @brief Parses the command-line arguments of drop_finder
+ * 
+ * Accepted arguments are the input file path and the following options:
+ * - --kernel=scalar|sse4.2|avx2: force the text scanning kernel
+ * - --threads=N: number of worker threads (default: one per core)
+ * - --no-cache: neither read nor write the .lvmb sample cache
+ * - --from=SECONDS, --to=SECONDS: time range to decode from a .lvma archive
+ * - --follow: keep processing the file while it is being written
+ * - --batch: keep whole signals in memory between the steps instead of
+ *   streaming the samples through them
+ * - --samples=double|float: storage of the signals kept by --batch
+ * - --out-of-core[=DIR]: --batch with the signals in scratch files in DIR
+ *   (default: the temporary directory) instead of RAM
+ * - --ram-budget=MB: bytes of those signals kept in RAM (default: 256)
+ * - --baseline=mean|median|histogram|ema: baseline removed by the normalizer
+ * - --engine=window|global: search the drops in a sliding window (default)
+ *   or over the whole signal at once (implies --batch)
+ * 
+ * @param argc Number of command-line arguments
+ * @param argv Array of command-line argument strings
+ * @return Parsed options
+ * @throws std::invalid_argument on unknown options or a missing input path
+ */
+Options parseOptions(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument.rfind("--kernel=", 0) == 0)
+        {
+            options.kernel = scanner::parseKernel(argument.substr(9));
+        }
+        else if (argument.rfind("--threads=", 0) == 0)
+        {
+            std::string value = argument.substr(10);
+            if (value.empty() ||
+                value.find_first_not_of("0123456789") != std::string::npos ||
+                (options.threads = std::stoul(value)) == 0)
+            {
+                throw std::invalid_argument("Invalid number of threads: " + value);
+            }
+        }
+        else if (argument.rfind("--from=", 0) == 0)
+        {
+            options.from = std::stod(argument.substr(7));
+        }
+        else if (argument.rfind("--to=", 0) == 0)
+        {
+            options.to = std::stod(argument.substr(5));
+        }
+        else if (argument == "--no-cache")
+        {
+            options.useCache = false;
+        }
+        else if (argument == "--follow")
+        {
+            options.follow = true;
+        }
+        else if (argument == "--batch")
+        {
+            options.batch = true;
+        }
+        else if (argument == "--out-of-core" || argument.rfind("--out-of-core=", 0) == 0)
+        {
+            options.batch = true;
+            options.scratchDirectory = argument.size() > 13
+                                           ? argument.substr(14)
+                                           : std::filesystem::temp_directory_path().string();
+        }
+        else if (argument.rfind("--ram-budget=", 0) == 0)
+        {
+            std::string value = argument.substr(13);
+            if (value.empty() ||
+                value.find_first_not_of("0123456789") != std::string::npos ||
+                std::stoul(value) == 0)
+            {
+                throw std::invalid_argument("Invalid RAM budget: " + value);
+            }
+            options.ramBudget = std::stoul(value) << 20;
+        }
+        else if (argument.rfind("--baseline=", 0) == 0)
+        {
+            options.baseline = normalizer::parseBaseline(argument.substr(11));
+        }
+        else if (argument.rfind("--engine=", 0) == 0)
+        {
+            std::string value = argument.substr(9);
+            if (value != "window" && value != "global")
+            {
+                throw std::invalid_argument("Unknown drop search engine: " + value);
+            }
+            options.globalEngine = value == "global";
+            options.batch = options.batch || options.globalEngine;
+        }
+        else if (argument.rfind("--samples=", 0) == 0)
+        {
+            options.precision = SampleBuffer::parsePrecision(argument.substr(10));
+        }
+        else if (argument.rfind("--", 0) == 0 || !options.inputPath.empty())
+        {
+            throw std::invalid_argument("Unexpected argument: " + argument);
+        }
+        else
+        {
+            options.inputPath = argument;
+        }
+    }
+    if (options.inputPath.empty())
+    {
+        throw std::invalid_argument("Missing input file path");
+    }
+    if (options.follow && (options.from != -INFINITY || options.to != INFINITY))
+    {
+        throw std::invalid_argument("--follow cannot be combined with --from/--to");
+    }
+    if (options.follow && options.batch)
+    {
+        throw std::invalid_argument("--follow cannot be combined with --batch/--out-of-core/--engine=global");
+    }
+    return options;
 }
 
 /**
  * @brief Main entry point for the drop finder application
  * 
  * This is the main function that handles command-line arguments and orchestrates
- * the drop detection process. It expects one command-line argument (input file path)
- * and outputs results to "drops.dat" in the current directory.
+ * the drop detection process. It expects the input file path (plus optional
+ * flags, see parseOptions) and outputs results to "drops.dat" in the current
+ * directory ("drops_1.dat", "drops_2.dat", ... for files with several
+ * sensor pairs).
  * 
  * @param argc Number of command-line arguments
  * @param argv Array of command-line argument strings
@@ -274,9 +1502,22 @@ int main(int argc, char *argv[])
     FAST_IO; // Enable fast I/O for better performance
     
     // Check for required command-line arguments
-    if (argc < 2)
+    Options options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::logic_error &e)
     {
-        std::cerr << "Usage: " << argv[0] << " <input file path>" << std::endl;
+        std::cerr << e.what() << std::endl;
+        std::cerr << "Usage: " << argv[0]
+                  << " [--kernel=scalar|sse4.2|avx2] [--threads=N] [--no-cache]"
+                  << " [--from=SECONDS] [--to=SECONDS] [--follow]"
+                  << " [--batch] [--samples=double|float]"
+                  << " [--out-of-core[=DIR]] [--ram-budget=MB]"
+                  << " [--baseline=mean|median|histogram|ema] [--engine=window|global]"
+                  << " <input file path>"
+                  << std::endl;
         return 1;
     }
 
@@ -286,7 +1527,14 @@ int main(int argc, char *argv[])
     try
     {
         // Run the main processing pipeline
-        perform(argv[1], outPath);
+        if (options.follow)
+        {
+            follow(options, outPath);
+        }
+        else
+        {
+            perform(options, outPath);
+        }
     }
     catch (const std::exception &e)
     {
@@ -0,0 +1,143 @@
+/**
+ * @file drops_diff.cpp
+ * @brief Compares two drops.dat files written by drop_finder
+ *
+ * Used to measure what an alternative processing path changes in the
+ * results, e.g. float sensor storage (--samples=float) against the default
+ * double path. Drops are matched by the time of their first sample; the
+ * report counts the drops found by only one of the files, the matched drops
+ * whose written values differ, and the largest differences of the charges,
+ * velocity, diameter and penalty of the matched drops.
+ */
+
+#include "Drop.hpp"
+#include "file.hpp"
+
+/**
+ * @brief Largest absolute and relative difference of one property
+ */
+struct Difference
+{
+    double absolute = 0;
+    double relative = 0;
+
+    void add(double a, double b)
+    {
+        double diff = std::abs(a - b);
+        absolute = std::max(absolute, diff);
+        if (diff > 0)
+        {
+            relative = std::max(relative, diff / std::max(std::abs(a), std::abs(b)));
+        }
+    }
+};
+
+/**
+ * @brief Reads a drops file, sorted by the time of the first sample
+ * @param filePath Path to the drops file
+ * @return Drops in the file
+ * @throws std::runtime_error if the file cannot be read
+ */
+std::vector<Drop> readDrops(const std::string &filePath)
+{
+    auto file = openFileRead(filePath);
+    std::vector<Drop> drops = Drop::readFromFile(file);
+    std::stable_sort(drops.begin(), drops.end(), [](const Drop &a, const Drop &b)
+                     { return a.time.front() < b.time.front(); });
+    return drops;
+}
+
+/**
+ * @brief Checks whether two drops were written with the same values
+ */
+bool sameValues(const Drop &a, const Drop &b)
+{
+    return a.time == b.time && a.sensor1 == b.sensor1 && a.sensor2 == b.sensor2 &&
+           a.integralSensor1 == b.integralSensor1 &&
+           a.integralSensor2 == b.integralSensor2 && a.a1 == b.a1 && a.a2 == b.a2 &&
+           a.b1 == b.b1 && a.q1 == b.q1 && a.q2 == b.q2 && a.v == b.v && a.d == b.d &&
+           a.penalty() == b.penalty();
+}
+
+/**
+ * @brief Compares two drops files and prints the report
+ * @param referencePath Drops of the reference path (e.g. double samples)
+ * @param otherPath Drops of the path being evaluated
+ * @return True if both files hold the same drops with the same values
+ */
+bool perform(const std::string &referencePath, const std::string &otherPath)
+{
+    std::vector<Drop> reference = readDrops(referencePath);
+    std::vector<Drop> other = readDrops(otherPath);
+
+    size_t matched = 0, identical = 0, onlyReference = 0, onlyOther = 0;
+    Difference q1, q2, v, d, penalty;
+    size_t i = 0, j = 0;
+    while (i < reference.size() || j < other.size())
+    {
+        double ti = i < reference.size() ? reference[i].time.front() : INFINITY;
+        double tj = j < other.size() ? other[j].time.front() : INFINITY;
+        if (std::abs(ti - tj) < 1e-9)
+        {
+            const Drop &a = reference[i++];
+            const Drop &b = other[j++];
+            matched++;
+            identical += sameValues(a, b);
+            q1.add(a.q1, b.q1);
+            q2.add(a.q2, b.q2);
+            v.add(a.v, b.v);
+            d.add(a.d, b.d);
+            penalty.add(a.penalty(), b.penalty());
+        }
+        else if (ti < tj)
+        {
+            onlyReference++;
+            i++;
+        }
+        else
+        {
+            onlyOther++;
+            j++;
+        }
+    }
+
+    std::cout << referencePath << ": " << reference.size() << " drops, "
+              << otherPath << ": " << other.size() << " drops" << std::endl;
+    std::cout << "Matched: " << matched << " (" << identical
+              << " identical), only in " << referencePath << ": " << onlyReference
+              << ", only in " << otherPath << ": " << onlyOther << std::endl;
+    std::cout << std::scientific << std::setprecision(2)
+              << "Max difference of matched drops (absolute / relative):" << std::endl
+              << "  q1      " << q1.absolute << " / " << q1.relative << std::endl
+              << "  q2      " << q2.absolute << " / " << q2.relative << std::endl
+              << "  v       " << v.absolute << " / " << v.relative << std::endl
+              << "  d       " << d.absolute << " / " << d.relative << std::endl
+              << "  penalty " << penalty.absolute << " / " << penalty.relative << std::endl;
+
+    return onlyReference == 0 && onlyOther == 0 && identical == matched;
+}
+
+/**
+ * @brief Main entry point: drops_diff <reference drops.dat> <other drops.dat>
+ * @return 0 if both files hold the same drops, 1 if they differ, 2 on error
+ */
+int main(int argc, char *argv[])
+{
+    FAST_IO;
+
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <reference drops.dat> <other drops.dat>"
+                  << std::endl;
+        return 2;
+    }
+    try
+    {
+        return perform(argv[1], argv[2]) ? 0 : 1;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+}
@@ -9,6 +9,13 @@
 
 #include "file.hpp"
 
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 /**
  * @brief Opens a file for reading with error checking
  * @param filePath Path to the file to open
@@ -51,55 +58,345 @@ std::ofstream openFileWrite(const std::string &filePath)
 }
 
 /**
- * @brief Reads entire file contents using memory mapping for efficiency
- * 
- * This function uses memory mapping to efficiently read large files
- * without loading them entirely into memory. It's particularly useful
- * for processing large sensor data files.
- * 
- * @param filePath Path to the file to read
- * @return String containing the entire file contents
- * @throws std::runtime_error if file cannot be read
+ * @brief Maps the whole file in read-only mode
+ *
+ * Empty files are not mapped (mmap rejects zero-length mappings); they
+ * simply expose an empty view.
+ *
+ * @param filePath Path to the file to map
+ * @throws std::runtime_error if the file cannot be opened or mapped
  */
-std::string readFileContents(const std::string &filePath)
+MappedFile::MappedFile(const std::string &filePath)
+    : mappedData(nullptr), mappedSize(0)
 {
     // Open file descriptor
     int fd = open(filePath.c_str(), O_RDONLY);
     if (fd == -1) {
         throw std::runtime_error("No se pudo abrir el archivo: " + filePath);
     }
-    
+
     // Get file size
     struct stat fileStat;
     if (fstat(fd, &fileStat) == -1) {
         close(fd);
         throw std::runtime_error("No se pudo obtener información del archivo: " + filePath);
     }
-    
+
     size_t fileSize = static_cast<size_t>(fileStat.st_size);
-    
+
     // Handle empty files
     if (fileSize == 0) {
         close(fd);
-        return std::string();
+        return;
     }
-    
+
     // Memory map the file for efficient reading
     void* mappedMemory = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
-    
+
     // Close file descriptor (mmap keeps its own reference)
     close(fd);
-    
+
     if (mappedMemory == MAP_FAILED) {
         throw std::runtime_error("No se pudo hacer memory mapping del archivo: " + filePath);
     }
-    
-    // Copy the mapped memory to a string
-    std::string contents(static_cast<const char*>(mappedMemory), fileSize);
-    
-    // Unmap the memory
-    munmap(mappedMemory, fileSize);
-    
-    return contents;
+
+    // The file is read front to back, let the kernel read ahead aggressively
+    madvise(mappedMemory, fileSize, MADV_SEQUENTIAL);
+
+    mappedData = static_cast<const char*>(mappedMemory);
+    mappedSize = fileSize;
+}
+
+MappedFile::~MappedFile()
+{
+    if (mappedData != nullptr) {
+        munmap(const_cast<char*>(mappedData), mappedSize);
+    }
+}
+
+std::string_view MappedFile::view() const
+{
+    return std::string_view(mappedData, mappedSize);
+}
+
+size_t MappedFile::size() const { return mappedSize; }
+
+void MappedFile::discard(size_t offset, size_t length) const
+{
+    // Only whole pages can be dropped
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t first = (offset + page - 1) / page * page;
+    size_t last = std::min(offset + length, mappedSize) / page * page;
+    if (mappedData != nullptr && first < last) {
+        madvise(const_cast<char*>(mappedData) + first, last - first, MADV_DONTNEED);
+    }
+}
+
+Compression detectCompression(std::string_view contents)
+{
+    if (contents.substr(0, 2) == std::string_view("\x1f\x8b", 2)) {
+        return Compression::Gzip;
+    }
+    if (contents.substr(0, 4) == std::string_view("\x28\xb5\x2f\xfd", 4)) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+const char *compressionName(Compression compression)
+{
+    switch (compression) {
+    case Compression::Gzip:
+        return "gzip";
+    case Compression::Zstd:
+        return "zstd";
+    default:
+        return "none";
+    }
+}
+
+/**
+ * @brief Starts decompressing a buffer on a background thread
+ *
+ * Support for each format is compiled in only when its library is found at
+ * build time (HAVE_ZLIB, HAVE_ZSTD); the check is made here so the caller
+ * gets the error before reading anything.
+ *
+ * @param compressed Compressed bytes (must outlive the stream)
+ * @param filePath Path of the file, for error messages
+ * @throws std::runtime_error if the buffer is not compressed or the
+ *         program was built without support for its format
+ */
+DecompressedStream::DecompressedStream(std::string_view compressed, const std::string &filePath)
+    : compressed(compressed), filePath(filePath), format(detectCompression(compressed)),
+      inputConsumed(0), done(false), stopped(false)
+{
+#ifndef HAVE_ZLIB
+    if (format == Compression::Gzip) {
+        throw std::runtime_error("Compilado sin soporte para gzip (zlib): " + filePath);
+    }
+#endif
+#ifndef HAVE_ZSTD
+    if (format == Compression::Zstd) {
+        throw std::runtime_error("Compilado sin soporte para zstd (libzstd): " + filePath);
+    }
+#endif
+    if (format == Compression::None) {
+        throw std::runtime_error("El archivo no está comprimido: " + filePath);
+    }
+    worker = std::thread(&DecompressedStream::run, this);
+}
+
+DecompressedStream::~DecompressedStream()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    changed.notify_all();
+    worker.join();
+}
+
+bool DecompressedStream::next(std::string &chunk)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return !ready.empty() || done; });
+    if (!ready.empty()) {
+        chunk = std::move(ready.front());
+        ready.pop_front();
+        lock.unlock();
+        changed.notify_all();
+        return true;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    chunk.clear();
+    return false;
 }
 
+size_t DecompressedStream::consumed() const { return inputConsumed; }
+
+Compression DecompressedStream::compression() const { return format; }
+
+void DecompressedStream::run()
+{
+    try {
+        if (format == Compression::Gzip) {
+            inflateGzip();
+        } else {
+            decompressZstd();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    changed.notify_all();
+}
+
+bool DecompressedStream::publish(std::string &chunk)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return ready.size() < QUEUE_DEPTH || stopped; });
+    if (stopped) {
+        return false;
+    }
+    ready.push_back(std::move(chunk));
+    lock.unlock();
+    changed.notify_all();
+    chunk.clear();
+    return true;
+}
+
+/**
+ * @brief Inflates every gzip member of the buffer
+ */
+void DecompressedStream::inflateGzip()
+{
+#ifdef HAVE_ZLIB
+    z_stream stream = {};
+    // 15 window bits + 16: gzip wrapper only
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        throw std::runtime_error("No se pudo iniciar la descompresión del archivo: " + filePath);
+    }
+    std::unique_ptr<z_stream, int (*)(z_stream *)> guard(&stream, inflateEnd);
+
+    std::string chunk;
+    size_t position = 0;
+    int status = Z_OK;
+    while (true) {
+        if (stream.avail_in == 0 && position < compressed.size()) {
+            // avail_in is 32 bits wide, feed the mapping in slices
+            size_t slice = std::min<size_t>(compressed.size() - position, 1u << 30);
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data() + position));
+            stream.avail_in = static_cast<uInt>(slice);
+            position += slice;
+        }
+        if (status == Z_STREAM_END) {
+            if (stream.avail_in == 0) {
+                break;
+            }
+            // Another gzip member follows (e.g. files written by pigz)
+            inflateReset(&stream);
+        }
+
+        size_t filled = chunk.size();
+        chunk.resize(CHUNK_SIZE);
+        stream.next_out = reinterpret_cast<Bytef *>(chunk.data() + filled);
+        stream.avail_out = static_cast<uInt>(CHUNK_SIZE - filled);
+        status = inflate(&stream, Z_NO_FLUSH);
+        chunk.resize(CHUNK_SIZE - stream.avail_out);
+        inputConsumed = position - stream.avail_in;
+
+        // Output room was left and the input ran out before the end of the member
+        if (status == Z_BUF_ERROR || (status == Z_OK && stream.avail_in == 0 &&
+                                      position == compressed.size() && stream.avail_out != 0)) {
+            throw std::runtime_error("Archivo gzip truncado: " + filePath);
+        }
+        if (status != Z_OK && status != Z_STREAM_END) {
+            throw std::runtime_error("Archivo gzip dañado (" +
+                                     std::string(stream.msg ? stream.msg : "inflate") +
+                                     "): " + filePath);
+        }
+        if (chunk.size() == CHUNK_SIZE && !publish(chunk)) {
+            return;
+        }
+    }
+    if (!chunk.empty()) {
+        publish(chunk);
+    }
+#endif
+}
+
+/**
+ * @brief Decompresses every zstd frame of the buffer
+ */
+void DecompressedStream::decompressZstd()
+{
+#ifdef HAVE_ZSTD
+    std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream *)> stream(ZSTD_createDStream(),
+                                                                      ZSTD_freeDStream);
+    if (!stream) {
+        throw std::runtime_error("No se pudo iniciar la descompresión del archivo: " + filePath);
+    }
+
+    std::string chunk;
+    ZSTD_inBuffer input = {compressed.data(), compressed.size(), 0};
+    size_t status = 0;
+    while (true) {
+        size_t filled = chunk.size();
+        chunk.resize(CHUNK_SIZE);
+        ZSTD_outBuffer output = {chunk.data(), CHUNK_SIZE, filled};
+        status = ZSTD_decompressStream(stream.get(), &output, &input);
+        if (ZSTD_isError(status)) {
+            throw std::runtime_error("Archivo zstd dañado (" +
+                                     std::string(ZSTD_getErrorName(status)) + "): " + filePath);
+        }
+        chunk.resize(output.pos);
+        inputConsumed = input.pos;
+
+        if (chunk.size() == CHUNK_SIZE && !publish(chunk)) {
+            return;
+        }
+        // All the input used and the output not full: nothing is left
+        if (input.pos == input.size && output.pos < output.size) {
+            break;
+        }
+    }
+    if (status != 0) {
+        throw std::runtime_error("Archivo zstd truncado: " + filePath);
+    }
+    if (!chunk.empty()) {
+        publish(chunk);
+    }
+#endif
+}
+
+/**
+ * @brief Extracts the next line from a buffer without copying it
+ * @param contents Buffer to read lines from
+ * @param position Offset of the next unread byte, advanced past the line
+ * @param line Output view over the extracted line
+ * @return False when there are no more lines in the buffer
+ */
+bool nextLine(std::string_view contents, size_t &position, std::string_view &line)
+{
+    if (position >= contents.size()) {
+        return false;
+    }
+
+    const char* begin = contents.data() + position;
+    size_t remaining = contents.size() - position;
+    const char* newline = static_cast<const char*>(std::memchr(begin, '\n', remaining));
+    size_t length = newline ? static_cast<size_t>(newline - begin) : remaining;
+
+    position += newline ? length + 1 : length;
+
+    // Tolerate files written with Windows line endings
+    if (length > 0 && begin[length - 1] == '\r') {
+        length--;
+    }
+    line = std::string_view(begin, length);
+    return true;
+}
+
+/**
+ * @brief Reads entire file contents using memory mapping for efficiency
+ * 
+ * This function uses memory mapping to efficiently read large files.
+ * Callers that only need to scan the contents should use MappedFile
+ * directly and avoid the copy into a std::string.
+ * 
+ * @param filePath Path to the file to read
+ * @return String containing the entire file contents
+ * @throws std::runtime_error if file cannot be read
+ */
+std::string readFileContents(const std::string &filePath)
+{
+    MappedFile file(filePath);
+    return std::string(file.view());
+}
@@ -7,8 +7,179 @@
  * file I/O operations with proper error handling.
  */
 
+#pragma once
+
 #include "lib.hpp"
 
+/**
+ * @class MappedFile
+ * @brief Read-only memory mapping of an entire file
+ *
+ * The mapping stays valid for the lifetime of the object, so callers can
+ * walk the file contents through std::string_view without copying them
+ * into a std::string first.
+ */
+class MappedFile
+{
+private:
+    const char *mappedData; // Start of the mapped bytes (nullptr if empty)
+    size_t mappedSize;      // Number of mapped bytes
+
+public:
+    /**
+     * @brief Maps the whole file in read-only mode
+     * @param filePath Path to the file to map
+     * @throws std::runtime_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(const std::string &filePath);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Returns a view over the mapped bytes
+     * @return View valid while this object is alive
+     */
+    std::string_view view() const;
+
+    /**
+     * @brief Returns the size of the mapped file
+     * @return Number of bytes in the file
+     */
+    size_t size() const;
+
+    /**
+     * @brief Tells the kernel a range of the mapping will not be read again
+     *
+     * The whole pages inside the range are dropped from memory (they are
+     * read from the file again if touched), so streaming through a large
+     * file does not keep all of it resident.
+     *
+     * @param offset First byte of the range
+     * @param length Number of bytes in the range
+     */
+    void discard(size_t offset, size_t length) const;
+};
+
+/**
+ * @brief Compression format of an input file
+ */
+enum class Compression
+{
+    None,
+    Gzip,
+    Zstd
+};
+
+/**
+ * @brief Detects the compression of a file from its magic bytes
+ * @param contents Contents (or at least the first bytes) of the file
+ * @return Gzip (1f 8b), Zstd (28 b5 2f fd) or None
+ */
+Compression detectCompression(std::string_view contents);
+
+/**
+ * @brief Returns a printable name for a compression format
+ * @param compression Format to name
+ * @return "none", "gzip" or "zstd"
+ */
+const char *compressionName(Compression compression);
+
+/**
+ * @class DecompressedStream
+ * @brief Decompresses a .gz or .zst buffer on a background thread
+ *
+ * The decompressed bytes are handed out in chunks of CHUNK_SIZE bytes, in
+ * order, while the next chunks are being decompressed. At most QUEUE_DEPTH
+ * chunks wait to be taken, so memory stays bounded whatever the size of
+ * the file and the decompressed contents never touch the disk.
+ * Concatenated gzip members and zstd frames are read one after another.
+ */
+class DecompressedStream
+{
+public:
+    static constexpr size_t CHUNK_SIZE = 1 << 20; // Bytes per decompressed chunk
+    static constexpr size_t QUEUE_DEPTH = 4;      // Chunks decompressed ahead
+
+    /**
+     * @brief Starts decompressing a buffer
+     * @param compressed Compressed bytes (must outlive the stream)
+     * @param filePath Path of the file, for error messages
+     * @throws std::runtime_error if the buffer is not compressed or the
+     *         program was built without support for its format
+     */
+    DecompressedStream(std::string_view compressed, const std::string &filePath);
+
+    ~DecompressedStream();
+
+    DecompressedStream(const DecompressedStream &) = delete;
+    DecompressedStream &operator=(const DecompressedStream &) = delete;
+
+    /**
+     * @brief Takes the next chunk of decompressed bytes
+     *
+     * Blocks until a chunk is ready.
+     *
+     * @param chunk Output chunk (its previous contents are discarded)
+     * @return False at the end of the decompressed data
+     * @throws std::runtime_error if the data is corrupt or truncated
+     */
+    bool next(std::string &chunk);
+
+    /**
+     * @brief Returns the compressed bytes consumed so far
+     */
+    size_t consumed() const;
+
+    /**
+     * @brief Returns the compression format of the buffer
+     */
+    Compression compression() const;
+
+private:
+    std::string_view compressed;       // Compressed bytes
+    std::string filePath;              // Path of the file, for error messages
+    Compression format;                // Compression format
+    std::atomic<size_t> inputConsumed; // Compressed bytes consumed so far
+    std::mutex mutex;                  // Guards the fields below
+    std::condition_variable changed;   // Signals a new chunk, a taken chunk or the end
+    std::deque<std::string> ready;     // Chunks waiting to be taken
+    bool done;                         // The decompressor has finished
+    bool stopped;                      // The reader is gone, stop decompressing
+    std::exception_ptr error;          // Error of the decompressor, if any
+    std::thread worker;                // Decompressor thread
+
+    /**
+     * @brief Body of the decompressor thread
+     */
+    void run();
+
+    /**
+     * @brief Hands a full chunk to the reader, waiting for room in the queue
+     * @param chunk Chunk to hand out (moved from)
+     * @return False if the reader is gone
+     */
+    bool publish(std::string &chunk);
+
+    void inflateGzip();
+    void decompressZstd();
+};
+
+/**
+ * @brief Extracts the next line from a buffer without copying it
+ *
+ * The returned line excludes the trailing '\n' (and '\r' if present).
+ * A final line without a trailing newline is also returned.
+ *
+ * @param contents Buffer to read lines from
+ * @param position Offset of the next unread byte, advanced past the line
+ * @param line Output view over the extracted line
+ * @return False when there are no more lines in the buffer
+ */
+bool nextLine(std::string_view contents, size_t &position, std::string_view &line);
+
 /**
  * @brief Opens a file for reading with error checking
  * @param filePath Path to the file to open
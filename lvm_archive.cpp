@@ -0,0 +1,108 @@
+/**
+ * @file lvm_archive.cpp
+ * @brief Converts a text .lvm storm into a compressed .lvma archive
+ *
+ * The archive keeps the samples quantized to the ADC resolution, delta
+ * encoded and bit packed in independent blocks (see SignalArchive), and
+ * can be given to drop_finder directly in place of the .lvm file.
+ */
+
+#include "LVMHeader.hpp"
+#include "SignalArchive.hpp"
+#include "file.hpp"
+#include "scanner.hpp"
+
+/**
+ * @brief Converts one .lvm file and reports the compression ratio
+ * @param inputPath Path to the text .lvm file
+ * @param outputPath Path of the archive to create
+ * @param resolution Quantization step of the sensors
+ * @param threads Number of parsing threads
+ */
+void perform(const std::string &inputPath, const std::string &outputPath,
+             double resolution, size_t threads)
+{
+    MappedFile file(inputPath);
+    LVMHeader header = LVMHeader::parse(file.view());
+    std::vector<scanner::Columns> chunks = scanner::parseColumns(
+        file.view().substr(header.dataOffset), threads, scanner::bestKernel(),
+        [](size_t) {}, header.lineCount);
+
+    SignalArchive::Summary summary = SignalArchive::write(
+        outputPath, chunks, resolution, file.size(), header.dataPerSecond);
+
+    std::cout << std::fixed << std::setprecision(2) << inputPath << " -> "
+              << outputPath << ": " << summary.rows << " samples, "
+              << file.size() / 1e6 << " MB -> " << summary.archiveSize / 1e6
+              << " MB (ratio " << double(file.size()) / summary.archiveSize
+              << "x, " << 8.0 * summary.archiveSize / std::max<uint64_t>(summary.rows, 1)
+              << " bits/sample)" << std::endl;
+    std::cout << std::scientific << std::setprecision(1)
+              << "Max quantization error: time " << summary.maxTimeError
+              << " s, sensors " << summary.maxSensorError << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    FAST_IO;
+
+    double resolution = SignalArchive::DEFAULT_RESOLUTION;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> paths;
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+            if (argument.rfind("--resolution=", 0) == 0)
+            {
+                resolution = std::stod(argument.substr(13));
+                if (!(resolution > 0))
+                    throw std::invalid_argument("Invalid resolution");
+            }
+            else if (argument.rfind("--threads=", 0) == 0)
+            {
+                threads = std::max(1ul, std::stoul(argument.substr(10)));
+            }
+            else if (argument.rfind("--", 0) == 0)
+            {
+                throw std::invalid_argument("Unexpected argument: " + argument);
+            }
+            else
+            {
+                paths.push_back(argument);
+            }
+        }
+        if (paths.empty() || paths.size() > 2)
+            throw std::invalid_argument("Expected an input and an optional output path");
+    }
+    catch (const std::logic_error &e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << "Usage: " << argv[0]
+                  << " [--resolution=VOLTS] [--threads=N] <input.lvm> [output.lvma]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::string outputPath = paths.size() == 2 ? paths[1] : paths[0];
+    if (paths.size() == 1)
+    {
+        std::filesystem::path path(paths[0]);
+        outputPath = path.extension() == ".lvm"
+                         ? path.replace_extension(".lvma").string()
+                         : paths[0] + ".lvma";
+    }
+
+    try
+    {
+        perform(paths[0], outputPath, resolution, threads);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
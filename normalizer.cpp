@@ -8,8 +8,410 @@
 
 #include "normalizer.hpp"
 
+#include <immintrin.h>
+
+namespace {
+
+// Scaled values from this one up are not added to the sums (1024 V)
+constexpr double MAX_UNITS = 1125899906842624.0; // 2^50
+
+// Adding and subtracting 1.5 * 2^52 rounds to the nearest integer
+constexpr double ROUNDING = 6755399441055744.0;
+
+/**
+ * @brief Converts a sensor value to units of 1 / WindowSums::VALUE_SCALE
+ * @param value Sensor value
+ * @param invalid Incremented if the value is too large (or NaN)
+ * @return Value in units, as the two's complement bits of an int64_t
+ */
+inline uint64_t toUnits(double value, size_t &invalid)
+{
+    double scaled = value * normalizer::WindowSums::VALUE_SCALE;
+    if (!(std::abs(scaled) < MAX_UNITS))
+    {
+        invalid++;
+        return 0;
+    }
+    return static_cast<uint64_t>(static_cast<int64_t>(scaled + ROUNDING - ROUNDING));
+}
+
+/**
+ * @struct Block
+ * @brief Arrays of one thread of normalizeWithRolling, reused for every block
+ *
+ * The rows of a block of output rows, plus a halo of half a window on
+ * each side, column by column; the prefix sums of their sensors; and the
+ * normalized sensors of the output rows.
+ */
+struct Block
+{
+    std::vector<int64_t> ticks;      // Ticks of the rows read
+    std::vector<double> sensor1;     // sensor1 of the rows read
+    std::vector<double> sensor2;     // sensor2 of the rows read
+    std::vector<uint64_t> sums1;     // sums1[i]: units of sensor1 before row i
+    std::vector<uint64_t> sums2;     // sums2[i]: units of sensor2 before row i
+    std::vector<double> normalized1; // Normalized sensor1 of the output rows
+    std::vector<double> normalized2; // Normalized sensor2 of the output rows
+};
+
+/**
+ * @brief Scalar kernel: prefix sums of a column, in units
+ * @param values Column of count values
+ * @param count Number of values
+ * @param sums Output, count + 1 prefix sums (sums[0] = 0)
+ * @return Number of values too large for the sums (added as 0)
+ */
+size_t prefixSumsScalar(const double *values, size_t count, uint64_t *sums)
+{
+    size_t invalid = 0;
+    sums[0] = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        sums[i + 1] = sums[i] + toUnits(values[i], invalid);
+    }
+    return invalid;
+}
+
+/**
+ * @brief AVX2 kernel: prefix sums of a column, in units
+ *
+ * Converts 4 values per step (same rounding as toUnits), then adds them up.
+ */
+__attribute__((target("avx2"))) size_t prefixSumsAVX2(const double *values, size_t count,
+                                                        uint64_t *sums)
+{
+    const __m256d scale = _mm256_set1_pd(normalizer::WindowSums::VALUE_SCALE);
+    const __m256d limit = _mm256_set1_pd(MAX_UNITS);
+    const __m256d rounding = _mm256_set1_pd(ROUNDING);
+    const __m256d magnitude = _mm256_castsi256_pd(_mm256_set1_epi64x(INT64_MAX));
+    size_t invalid = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d scaled = _mm256_mul_pd(_mm256_loadu_pd(values + i), scale);
+        // All ones in the lanes under the limit (never for NaN)
+        __m256d valid = _mm256_cmp_pd(_mm256_and_pd(scaled, magnitude), limit, _CMP_LT_OQ);
+        invalid += 4 - __builtin_popcount(_mm256_movemask_pd(valid));
+        // The low bits of x + 1.5 * 2^52 are the rounded x, biased by those
+        // of 1.5 * 2^52
+        __m256i units = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(scaled, rounding)),
+                                         _mm256_castpd_si256(rounding));
+        units = _mm256_and_si256(units, _mm256_castpd_si256(valid));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums + i + 1), units);
+    }
+    for (; i < count; i++)
+    {
+        sums[i + 1] = toUnits(values[i], invalid);
+    }
+
+    sums[0] = 0;
+    for (i = 0; i < count; i++)
+    {
+        sums[i + 1] += sums[i];
+    }
+    return invalid;
+}
+
+/**
+ * @brief Scalar kernel: subtracts the window means from the output rows
+ * @param block Rows read and their prefix sums
+ * @param outputs Number of output rows
+ * @param halfWindow Rows on each side of a normalized row
+ */
+void normalizeScalar(Block &block, size_t outputs, size_t halfWindow)
+{
+    size_t windowSize = 2 * halfWindow + 1;
+    double divisor = windowSize * normalizer::WindowSums::VALUE_SCALE;
+    for (size_t i = 0; i < outputs; i++)
+    {
+        uint64_t sum1 = block.sums1[i + windowSize] - block.sums1[i];
+        uint64_t sum2 = block.sums2[i + windowSize] - block.sums2[i];
+        block.normalized1[i] = block.sensor1[i + halfWindow] - static_cast<int64_t>(sum1) / divisor;
+        block.normalized2[i] = block.sensor2[i + halfWindow] - static_cast<int64_t>(sum2) / divisor;
+    }
+}
+
+/**
+ * @brief Converts 4 int64_t to double, rounded as a scalar conversion
+ *
+ * The high 16 bits (shifted into a double with exponent 2^68) and the
+ * low 48 bits (into one with exponent 2^52) are both exact; adding them
+ * rounds once.
+ */
+__attribute__((target("avx2"))) inline __m256d toDouble(__m256i x)
+{
+    const __m256d highBias = _mm256_set1_pd(442721857769029238784.0); // 3 * 2^67
+    const __m256d lowBias = _mm256_set1_pd(4503599627370496.0);       // 2^52
+    __m256i high = _mm256_srai_epi32(x, 16);
+    high = _mm256_blend_epi16(high, _mm256_setzero_si256(), 0x33);
+    high = _mm256_add_epi64(high, _mm256_castpd_si256(highBias));
+    __m256i low = _mm256_blend_epi16(x, _mm256_castpd_si256(lowBias), 0x88);
+    __m256d highValue = _mm256_sub_pd(_mm256_castsi256_pd(high),
+                                      _mm256_add_pd(highBias, lowBias));
+    return _mm256_add_pd(highValue, _mm256_castsi256_pd(low));
+}
+
+/**
+ * @brief AVX2 kernel: subtracts the window means from the output rows
+ *
+ * 4 rows per step, bit-identical to normalizeScalar.
+ */
+__attribute__((target("avx2"))) void normalizeAVX2(Block &block, size_t outputs,
+                                                     size_t halfWindow)
+{
+    size_t windowSize = 2 * halfWindow + 1;
+    double divisor = windowSize * normalizer::WindowSums::VALUE_SCALE;
+    const __m256d divisors = _mm256_set1_pd(divisor);
+    const uint64_t *sums[] = {block.sums1.data(), block.sums2.data()};
+    const double *sensors[] = {block.sensor1.data(), block.sensor2.data()};
+    double *normalized[] = {block.normalized1.data(), block.normalized2.data()};
+    for (size_t column = 0; column < 2; column++)
+    {
+        const uint64_t *sum = sums[column];
+        const double *sensor = sensors[column];
+        double *output = normalized[column];
+        size_t i = 0;
+        for (; i + 4 <= outputs; i += 4)
+        {
+            __m256i after = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sum + i + windowSize));
+            __m256i before = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sum + i));
+            __m256d mean = _mm256_div_pd(toDouble(_mm256_sub_epi64(after, before)), divisors);
+            _mm256_storeu_pd(output + i,
+                             _mm256_sub_pd(_mm256_loadu_pd(sensor + i + halfWindow), mean));
+        }
+        for (; i < outputs; i++)
+        {
+            output[i] = sensor[i + halfWindow] -
+                        static_cast<int64_t>(sum[i + windowSize] - sum[i]) / divisor;
+        }
+    }
+}
+
+/**
+ * @brief Normalizes a block pushing its rows through a RollingNormalizer
+ *
+ * Used for the median baselines, and for blocks with values too large for
+ * the prefix sums (the mean is then NaN wherever the window holds one).
+ */
+void normalizeSliding(Block &block, size_t outputs, double dataPerSecond,
+                      normalizer::Baseline baseline)
+{
+    normalizer::RollingNormalizer normalizer(dataPerSecond, baseline);
+    size_t produced = 0;
+    for (size_t i = 0; produced < outputs; i++)
+    {
+        LVM::Row normalized;
+        if (normalizer.push(LVM::Row{0, block.sensor1[i], block.sensor2[i], 0}, normalized))
+        {
+            block.normalized1[produced] = normalized.sensor1;
+            block.normalized2[produced] = normalized.sensor2;
+            produced++;
+        }
+    }
+}
+
+/**
+ * @brief Normalizes a whole signal with a causal baseline, on one thread
+ *
+ * Reads BLOCK_ROWS rows at a time and pushes them through a single
+ * RollingNormalizer, which normalizes every row as it is pushed.
+ */
+void normalizeCausal(const SampleBuffer &data, SampleBuffer &normalizedData, CLI &cli,
+                     double dataPerSecond, normalizer::Baseline baseline)
+{
+    normalizer::RollingNormalizer normalizer(dataPerSecond, baseline);
+    normalizedData.reserve(normalizedData.size() + data.size());
+    Block block;
+    size_t blockRows = std::min(data.size(), normalizer::BLOCK_ROWS);
+    block.ticks.resize(blockRows);
+    block.sensor1.resize(blockRows);
+    block.sensor2.resize(blockRows);
+    for (size_t first = 0; first < data.size(); first += blockRows)
+    {
+        size_t count = std::min(blockRows, data.size() - first);
+        data.read(first, count, block.ticks.data(), block.sensor1.data(), block.sensor2.data());
+        for (size_t i = 0; i < count; i++)
+        {
+            LVM::Row normalized;
+            normalizer.push(LVM::Row{block.ticks[i], block.sensor1[i], block.sensor2[i], 0},
+                            normalized);
+            block.sensor1[i] = normalized.sensor1;
+            block.sensor2[i] = normalized.sensor2;
+        }
+        normalizedData.append(block.ticks.data(), block.sensor1.data(), block.sensor2.data(),
+                              count);
+        cli.updateProgress("normalize", first + count);
+    }
+}
+
+}
+
 namespace normalizer {
 
+const char *baselineName(Baseline baseline)
+{
+    switch (baseline)
+    {
+    case Baseline::Median:
+        return "median";
+    case Baseline::Histogram:
+        return "histogram";
+    case Baseline::Ema:
+        return "ema";
+    default:
+        return "mean";
+    }
+}
+
+Baseline parseBaseline(const std::string &name)
+{
+    for (Baseline baseline :
+         {Baseline::Mean, Baseline::Median, Baseline::Histogram, Baseline::Ema})
+    {
+        if (name == baselineName(baseline))
+            return baseline;
+    }
+    throw std::invalid_argument("Unknown baseline: " + name);
+}
+
+void WindowSums::add(const LVM::Row &row)
+{
+    sensor1 += toUnits(row.sensor1, invalid);
+    sensor2 += toUnits(row.sensor2, invalid);
+}
+
+void WindowSums::remove(const LVM::Row &row)
+{
+    size_t removed = 0;
+    sensor1 -= toUnits(row.sensor1, removed);
+    sensor2 -= toUnits(row.sensor2, removed);
+    invalid -= removed;
+}
+
+void WindowSums::means(size_t windowSize, double &mean1, double &mean2) const
+{
+    if (invalid > 0)
+    {
+        mean1 = NAN;
+        mean2 = NAN;
+        return;
+    }
+    double divisor = windowSize * VALUE_SCALE;
+    mean1 = static_cast<int64_t>(sensor1) / divisor;
+    mean2 = static_cast<int64_t>(sensor2) / divisor;
+}
+
+void WindowSums::normalize(LVM::Row &row, size_t windowSize) const
+{
+    double mean1, mean2;
+    means(windowSize, mean1, mean2);
+    row.sensor1 -= mean1;
+    row.sensor2 -= mean2;
+}
+
+RollingNormalizer::RollingNormalizer(double dataPerSecond, Baseline baseline)
+    : halfWindow(halfWindowFor(dataPerSecond)), pushed(0), baseline(baseline),
+      smoothing(2.0 / (halfWindow * 2 + 2)), average1(0), average2(0), averaged(0), frozen(0)
+{
+    // The average keeps no rows: the window is only needed by the others
+    if (baseline != Baseline::Ema)
+        window.resize(halfWindow * 2 + 1);
+    if (baseline == Baseline::Median)
+        medians.assign(2, RollingMedian(window.size()));
+    else if (baseline == Baseline::Histogram)
+        histograms.assign(2, HistogramMedian(window.size()));
+}
+
+size_t RollingNormalizer::halfWindowFor(double dataPerSecond)
+{
+    size_t windowSize = std::lround(WINDOW_SIZE * dataPerSecond / DATA_PER_SECOND);
+    return windowSize / 2;
+}
+
+bool RollingNormalizer::push(const LVM::Row &row, LVM::Row &normalized)
+{
+    if (baseline == Baseline::Ema)
+    {
+        pushEma(row, normalized);
+        return true;
+    }
+
+    size_t actualWindowSize = window.size();
+    size_t slot = pushed % actualWindowSize;
+
+    // If we exceed the window size, remove the oldest values
+    if (pushed >= actualWindowSize && baseline == Baseline::Mean)
+    {
+        sums.remove(window[slot]);
+    }
+    window[slot] = row;
+    pushed++;
+    switch (baseline)
+    {
+    case Baseline::Median:
+        medians[0].push(row.sensor1);
+        medians[1].push(row.sensor2);
+        break;
+    case Baseline::Histogram:
+        histograms[0].push(row.sensor1);
+        histograms[1].push(row.sensor2);
+        break;
+    default:
+        sums.add(row);
+    }
+
+    // Only output normalized data when we have a full window
+    if (pushed < actualWindowSize)
+    {
+        return false;
+    }
+
+    // Create a normalized row for the center of the window
+    normalized = window[(pushed - 1 - halfWindow) % actualWindowSize];
+    switch (baseline)
+    {
+    case Baseline::Median:
+        normalized.sensor1 -= medians[0].median();
+        normalized.sensor2 -= medians[1].median();
+        break;
+    case Baseline::Histogram:
+        normalized.sensor1 -= histograms[0].median();
+        normalized.sensor2 -= histograms[1].median();
+        break;
+    default:
+        sums.normalize(normalized, actualWindowSize);
+    }
+    return true;
+}
+
+void RollingNormalizer::pushEma(const LVM::Row &row, LVM::Row &normalized)
+{
+    normalized = row;
+    if (averaged == 0)
+    {
+        average1 = row.sensor1;
+        average2 = row.sensor2;
+    }
+    normalized.sensor1 -= average1;
+    normalized.sensor2 -= average2;
+
+    // NaN rows cannot be averaged; rows of drops should not be
+    if (!std::isfinite(normalized.sensor1) || !std::isfinite(normalized.sensor2))
+        return;
+    bool deviates = std::abs(normalized.sensor1) >= MINIMUM_THRESHOLD ||
+                    std::abs(normalized.sensor2) >= MINIMUM_THRESHOLD;
+    if (!deviates)
+        frozen = 0;
+    else if (++frozen <= MAX_FROZEN_ROWS)
+        return;
+
+    // Plain mean of the first rows, until they weigh less than a new one
+    averaged++;
+    double weight = std::max(smoothing, 1.0 / averaged);
+    average1 += weight * (row.sensor1 - average1);
+    average2 += weight * (row.sensor2 - average2);
+}
+
 /**
  * @brief Normalizes sensor data using a rolling window approach
  * 
@@ -21,57 +423,111 @@ namespace normalizer {
  * 
  * The algorithm ensures that only data points with a full window of
  * surrounding data are normalized, maintaining data quality at the edges.
+ * The output is computed BLOCK_ROWS rows per thread at a time. Each block
+ * is read column by column, the window sums are differences of its prefix
+ * sums (restarted from 0 at every block, and exact; see WindowSums) and
+ * the means are subtracted 4 rows at a time with the AVX2 kernel. The
+ * median baselines slide a RollingNormalizer over each block instead.
  * 
- * @param data Vector of LVM::Row objects containing the raw sensor data
+ * @param data Raw sensor data
+ * @param normalizedData Output buffer the normalized rows are appended to
  * @param cli Reference to CLI for progress reporting
- * @return Vector of normalized LVM::Row objects
+ * @param dataPerSecond Sample rate of the data
+ * @param threads Number of worker threads
+ * @param kernel AVX2, or any other for the scalar kernel
+ * @param baseline Estimator of the baseline
  */
-std::vector<LVM::Row>
-normalizeWithRolling(const std::vector<LVM::Row> &data, CLI &cli)
+void normalizeWithRolling(const SampleBuffer &data, SampleBuffer &normalizedData,
+                          CLI &cli, double dataPerSecond, size_t threads,
+                          scanner::Kernel kernel, Baseline baseline)
 {
+    size_t halfWindow = RollingNormalizer::halfWindowFor(dataPerSecond);
+    size_t windowSize = 2 * halfWindow + 1;
+    // Row i of the output is row i + halfWindow of the input
+    size_t outputs = data.size() < windowSize ? 0 : data.size() - windowSize + 1;
+    threads = std::max<size_t>(1, threads);
+    bool avx2 = kernel == scanner::Kernel::AVX2;
+
     cli.startProgress("normalize", "Normalizing data", data.size());
-    
-    // Initialize variables for rolling window calculations
-    double sumSensor1 = 0.0;
-    double sumSensor2 = 0.0;
-    std::vector<LVM::Row> normalizedData;
-    size_t halfWindow = WINDOW_SIZE / 2;
-    size_t actualWindowSize = halfWindow * 2 + 1;
 
-    size_t currentSize = 0;
+    if (baseline == Baseline::Ema)
+    {
+        normalizeCausal(data, normalizedData, cli, dataPerSecond, baseline);
+        cli.finishProgress("normalize");
+        return;
+    }
+
+    normalizedData.reserve(normalizedData.size() + outputs);
+
+    // Every thread fills a block of its own, appended in order once all
+    // of them are done
+    size_t blockRows = std::min(outputs, BLOCK_ROWS);
+    std::vector<Block> blocks(threads);
+    for (Block &block : blocks)
+    {
+        size_t rows = blockRows + windowSize - 1;
+        block.ticks.resize(rows);
+        block.sensor1.resize(rows);
+        block.sensor2.resize(rows);
+        if (baseline == Baseline::Mean)
+        {
+            block.sums1.resize(rows + 1);
+            block.sums2.resize(rows + 1);
+        }
+        block.normalized1.resize(blockRows);
+        block.normalized2.resize(blockRows);
+    }
 
-    for (size_t i = 0; i < data.size(); ++i)
+    // Normalizes the output rows [first, first + count) into a block
+    auto normalizeBlock = [&](size_t first, size_t count, Block &block)
     {
-        // Add the current row's values to the running sums
-        sumSensor1 += data[i].sensor1;
-        sumSensor2 += data[i].sensor2;
-        ++currentSize;
+        size_t rows = count + windowSize - 1;
+        data.read(first, rows, block.ticks.data(), block.sensor1.data(), block.sensor2.data());
+        if (baseline != Baseline::Mean)
+        {
+            normalizeSliding(block, count, dataPerSecond, baseline);
+            return;
+        }
+        size_t invalid = avx2 ? prefixSumsAVX2(block.sensor1.data(), rows, block.sums1.data()) +
+                                    prefixSumsAVX2(block.sensor2.data(), rows, block.sums2.data())
+                              : prefixSumsScalar(block.sensor1.data(), rows, block.sums1.data()) +
+                                    prefixSumsScalar(block.sensor2.data(), rows, block.sums2.data());
+        if (invalid > 0)
+            normalizeSliding(block, count, dataPerSecond, baseline);
+        else if (avx2)
+            normalizeAVX2(block, count, halfWindow);
+        else
+            normalizeScalar(block, count, halfWindow);
+    };
 
-        // If we exceed the window size, remove the oldest values
-        if (currentSize > actualWindowSize)
+    for (size_t round = 0; round < outputs; round += threads * BLOCK_ROWS)
+    {
+        size_t active = std::min(threads, (outputs - round + BLOCK_ROWS - 1) / BLOCK_ROWS);
+        auto count = [&](size_t t)
+        {
+            return std::min(BLOCK_ROWS, outputs - (round + t * BLOCK_ROWS));
+        };
+        auto work = [&](size_t t) { normalizeBlock(round + t * BLOCK_ROWS, count(t), blocks[t]); };
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < active; t++)
+        {
+            workers.emplace_back(work, t);
+        }
+        work(0);
+        for (std::thread &worker : workers)
         {
-            sumSensor1 -= data[i - actualWindowSize].sensor1;
-            sumSensor2 -= data[i - actualWindowSize].sensor2;
-            --currentSize;
+            worker.join();
         }
 
-        // Only output normalized data when we have a full window
-        if (currentSize == actualWindowSize)
+        for (size_t t = 0; t < active; t++)
         {
-            // Calculate local averages
-            double meanSensor1 = sumSensor1 / actualWindowSize;
-            double meanSensor2 = sumSensor2 / actualWindowSize;
-
-            // Create a normalized row for the center of the window
-            LVM::Row normalizedRow = data[i - halfWindow];
-            normalizedRow.sensor1 -= meanSensor1;
-            normalizedRow.sensor2 -= meanSensor2;
-            normalizedData.push_back(normalizedRow);
+            const Block &block = blocks[t];
+            normalizedData.append(block.ticks.data() + halfWindow, block.normalized1.data(),
+                                  block.normalized2.data(), count(t));
         }
-        cli.updateProgress("normalize", i);
+        cli.updateProgress("normalize", std::min(outputs, round + active * BLOCK_ROWS));
     }
     cli.finishProgress("normalize");
-    return normalizedData;
 }
 
 }
@@ -10,9 +10,13 @@
 #pragma once
 
 #include "LVM.hpp"
+#include "SampleBuffer.hpp"
 #include "constants.hpp"
 #include "lib.hpp"
 #include "cli.hpp"
+#include "scanner.hpp"
+#include "RollingMedian.hpp"
+#include "HistogramMedian.hpp"
 
 /**
  * @namespace normalizer
@@ -20,6 +24,154 @@
  */
 namespace normalizer {
 
+    // Output rows computed by each thread of normalizeWithRolling at a time
+    constexpr size_t BLOCK_ROWS = 1 << 16;
+
+    /**
+     * @brief Estimator of the baseline subtracted from each row
+     */
+    enum class Baseline
+    {
+        Mean,     // Mean of the window (exact sums, see WindowSums)
+        Median,   // Exact median of the window (RollingMedian)
+        Histogram, // Approximate median of the window (HistogramMedian)
+        Ema        // Causal exponential moving average of the past rows
+    };
+
+    /**
+     * @brief Returns a printable name for a baseline
+     * @param baseline Baseline to name
+     * @return "mean", "median", "histogram" or "ema"
+     */
+    const char *baselineName(Baseline baseline);
+
+    /**
+     * @brief Parses a baseline name as accepted on the command line
+     * @param name One of "mean", "median", "histogram" or "ema"
+     * @return Matching baseline
+     * @throws std::invalid_argument if the name is unknown
+     */
+    Baseline parseBaseline(const std::string &name);
+
+    /**
+     * @struct WindowSums
+     * @brief Exact sums of both sensors over a window of rows
+     * 
+     * Sensor values are added as integers in units of 1 / VALUE_SCALE (a
+     * power of two, so the scaling itself is exact and only the rounding
+     * to a unit, about 1e-12 V, is lost). The sums of a window are
+     * therefore the same whatever rows were added and removed before:
+     * they never drift, and a window summed from scratch gives bit for bit
+     * the same mean as one reached by sliding. Unsigned so they wrap
+     * instead of overflowing; the sum of a whole window still fits while
+     * its values add up to less than 2^23 volts.
+     */
+    struct WindowSums
+    {
+        static constexpr double VALUE_SCALE = 1099511627776.0; // Units per volt (2^40)
+
+        uint64_t sensor1 = 0; // Sum of sensor1
+        uint64_t sensor2 = 0; // Sum of sensor2
+        size_t invalid = 0;   // Values too large for the sums (NaN included)
+
+        /**
+         * @brief Adds a row to the window
+         */
+        void add(const LVM::Row &row);
+
+        /**
+         * @brief Removes a row added before
+         */
+        void remove(const LVM::Row &row);
+
+        /**
+         * @brief Returns the means of both sensors over the window
+         * @param windowSize Number of rows in the window
+         * @param mean1 Output mean of sensor1 (NaN if the window has invalid values)
+         * @param mean2 Output mean of sensor2 (NaN if the window has invalid values)
+         */
+        void means(size_t windowSize, double &mean1, double &mean2) const;
+
+        /**
+         * @brief Subtracts the window means from a row
+         * @param row Row to normalize (NaN if the window has invalid values)
+         * @param windowSize Number of rows in the window
+         */
+        void normalize(LVM::Row &row, size_t windowSize) const;
+    };
+
+    /**
+     * @class RollingNormalizer
+     * @brief Stateful rolling window normalization, one row at a time
+     * 
+     * Keeps the last window of rows and the running sums of both sensors
+     * (or, for the median baselines, a RollingMedian or HistogramMedian
+     * per sensor). Each pushed row completes the window of the row halfWindow rows
+     * before it, which comes out normalized; the first halfWindow rows of
+     * the signal never have a full window and are dropped, exactly as in
+     * normalizeWithRolling.
+     * 
+     * Baseline::Ema is causal instead: each pushed row comes out right
+     * away, minus an exponential moving average of the rows before it
+     * (with the same mean age as the window), and only that average is
+     * kept. The average is frozen while a row deviates from it by
+     * MINIMUM_THRESHOLD or more, so drops do not pull it; a deviation
+     * lasting longer than DROP_SIZE rows is no drop but a shift of the
+     * baseline, which the average then follows. Freezing goes by the
+     * deviation only: rows are normalized before the drop search marks
+     * any of them as used.
+     */
+    class RollingNormalizer
+    {
+    public:
+        /**
+         * @brief Constructor for a rolling normalizer
+         * @param dataPerSecond Sample rate of the data
+         * @param baseline Estimator of the baseline
+         */
+        explicit RollingNormalizer(double dataPerSecond = DATA_PER_SECOND,
+                                   Baseline baseline = Baseline::Mean);
+
+        // Rows at most the average of Baseline::Ema stays frozen
+        static constexpr size_t MAX_FROZEN_ROWS = DROP_SIZE;
+
+        /**
+         * @brief Returns the rows on each side of the normalized row
+         * 
+         * The window spans the same time at any sample rate: WINDOW_SIZE
+         * samples at DATA_PER_SECOND.
+         * 
+         * @param dataPerSecond Sample rate of the data
+         */
+        static size_t halfWindowFor(double dataPerSecond);
+
+        /**
+         * @brief Pushes the next row of the signal
+         * @param row Next row, in time order
+         * @param normalized Output normalized row, when there is one
+         * @return True if a normalized row was produced
+         */
+        bool push(const LVM::Row &row, LVM::Row &normalized);
+
+    private:
+        std::vector<LVM::Row> window; // Ring buffer with the last rows
+        size_t halfWindow;            // Rows on each side of the normalized row
+        size_t pushed;                // Rows pushed so far
+        Baseline baseline;            // Estimator of the baseline
+        WindowSums sums;              // Sums of the sensors over the window (Baseline::Mean)
+        std::vector<RollingMedian> medians;      // Per sensor (Baseline::Median)
+        std::vector<HistogramMedian> histograms; // Per sensor (Baseline::Histogram)
+        double smoothing;             // Weight of a new row in the average (Baseline::Ema)
+        double average1, average2;    // Averages of the sensors (Baseline::Ema)
+        size_t averaged;              // Rows in the averages (Baseline::Ema)
+        size_t frozen;                // Consecutive deviating rows (Baseline::Ema)
+
+        /**
+         * @brief Normalizes a row with Baseline::Ema and updates the averages
+         */
+        void pushEma(const LVM::Row &row, LVM::Row &normalized);
+    };
+
     /**
      * @brief Normalizes sensor data using a rolling window approach
      * 
@@ -28,9 +180,35 @@ namespace normalizer {
      * the original data. This helps eliminate long-term drift and offset
      * variations that can interfere with drop detection.
      * 
-     * @param data Vector of LVM::Row objects containing the raw sensor data
+     * The window spans the same time at any sample rate: WINDOW_SIZE
+     * samples at DATA_PER_SECOND.
+     * 
+     * The output is split in blocks of BLOCK_ROWS rows, one per thread at
+     * a time. Each block reads a halo of half a window on each side of it
+     * into arrays of its own, one per column, and takes its window sums
+     * from prefix sums that start at the block, so the blocks do not
+     * depend on each other; thanks to the exact sums of WindowSums the
+     * result is identical to a single pass (and to RollingNormalizer)
+     * whatever the number of threads or the kernel.
+     * 
+     * The median baselines have no prefix sums: each block pushes its rows
+     * through a RollingNormalizer of its own instead. The median of a
+     * window only depends on the values in it, so they are also identical
+     * to a single pass. Baseline::Ema depends on every row before, so it
+     * runs on a single thread, and normalizes every row.
+     * 
+     * @param data Raw sensor data (read from every thread at once, so it
+     *        must be stored in memory)
+     * @param normalizedData Output buffer the normalized rows are appended to
      * @param cli Reference to CLI for progress reporting
-     * @return Vector of normalized LVM::Row objects
+     * @param dataPerSecond Sample rate of the data
+     * @param threads Number of worker threads
+     * @param kernel Kernel::AVX2 for the vector kernel, scalar otherwise
+     * @param baseline Estimator of the baseline
      */
-    std::vector<LVM::Row> normalizeWithRolling(const std::vector<LVM::Row> &data, CLI &cli);
+    void normalizeWithRolling(const SampleBuffer &data, SampleBuffer &normalizedData,
+                              CLI &cli, double dataPerSecond = DATA_PER_SECOND,
+                              size_t threads = 1,
+                              scanner::Kernel kernel = scanner::bestKernel(),
+                              Baseline baseline = Baseline::Mean);
 }
@@ -28,7 +28,7 @@ def compile_programs(clean: bool):
 
 
 def run_drop_finder(file: str, force: bool, quiet: bool = False):
-    if force or not os.path.exists("drops.dat"):
+    if force or not (os.path.exists("drops.dat") or glob.glob("par_*")):
         if not quiet:
             print(f"Ejecutando drop_finder")
 
@@ -38,35 +38,47 @@ def run_drop_finder(file: str, force: bool, quiet: bool = False):
         os.system(cmd)
 
 
-def run_drop_sorter(force: bool, quiet: bool = False):
+def split_sensor_pairs(quiet: bool = False):
+    """Mueve el drops_<k>.dat y gaps_<k>.dat de cada par de sensores a su carpeta par_<k>/."""
+    for name in ("drops", "gaps"):
+        for path in glob.glob(f"{name}_[0-9]*.dat"):
+            folder = "par_" + path[len(name) + 1:-len(".dat")]
+            if not quiet:
+                print(f"Moviendo {path} a {folder}")
+            os.makedirs(folder, exist_ok=True)
+            os.replace(path, os.path.join(folder, f"{name}.dat"))
+    return sorted(glob.glob("par_*"))
+
+
+def run_drop_sorter(force: bool, quiet: bool = False, exec_dir: str = "../exec"):
     if force or not os.path.exists("drops_sorted.dat"):
         if not quiet:
             print(f"Ejecutando drop_sorter")
         
-        cmd = f"../exec/drop_sorter"
+        cmd = f"{exec_dir}/drop_sorter"
         if quiet:
             cmd += " > /dev/null 2>&1"
         os.system(cmd)
 
 
-def run_drop_charts(force: bool, quiet: bool = False):
+def run_drop_charts(force: bool, quiet: bool = False, exec_dir: str = "../exec"):
     if force or not os.path.exists("graficos"):
         if not quiet:
             print(f"Ejecutando drop_charts")
         
-        cmd = f"../exec/drop_chart"
+        cmd = f"{exec_dir}/drop_chart"
         if quiet:
             cmd += " > /dev/null 2>&1"
         os.system(cmd)
 
 
-def run_carga_velocidad(force: bool, quiet: bool = False):
+def run_carga_velocidad(force: bool, quiet: bool = False, exec_dir: str = "../exec"):
     """Ejecuta el programa Fortran que resume drops.dat en carga_velocidad.dat."""
     if force or not os.path.exists("carga_velocidad.dat"):
         if not quiet:
             print(f"Ejecutando carga_velocidad")
 
-        cmd = f"../exec/carga_velocidad"
+        cmd = f"{exec_dir}/carga_velocidad"
         if quiet:
             cmd += " > /dev/null 2>&1"
         os.system(cmd)
@@ -86,11 +98,17 @@ def analyze_storm(file: str, from_step: int, quiet: bool = False):
         os.chdir(folder)
         # 3. Ejecutamos el programa drop_finder
         run_drop_finder(file, from_step <= 1, quiet)
-        # 4. Ejecutamos el programa drop_sorter
-        run_drop_sorter(from_step <= 2, quiet)
-        # 5. Ejecutamos el programa drop_charts
-        run_drop_charts(from_step <= 3, quiet)
-        run_carga_velocidad(from_step <= 4, quiet)
+        # Con varios pares de sensores, cada par sigue en su propia carpeta
+        pair_folders = split_sensor_pairs(quiet)
+        for pair_folder in pair_folders or ["."]:
+            os.chdir(pair_folder)
+            exec_dir = "../exec" if pair_folder == "." else "../../exec"
+            # 4. Ejecutamos el programa drop_sorter
+            run_drop_sorter(from_step <= 2, quiet, exec_dir)
+            # 5. Ejecutamos el programa drop_charts
+            run_drop_charts(from_step <= 3, quiet, exec_dir)
+            run_carga_velocidad(from_step <= 4, quiet, exec_dir)
+            os.chdir(os.path.join(original_dir, folder))
         
         if not quiet:
             print(f"[{os.getpid()}] Análisis completado para {file}")
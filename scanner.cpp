@@ -0,0 +1,524 @@
+/**
+ * @file scanner.cpp
+ * @brief Implementation of the vectorized LVM text scanner
+ *
+ * The vector kernels are compiled with per-function target attributes, so
+ * the binary still runs on CPUs without AVX2/SSE4.2: the kernel is picked
+ * at runtime from what the CPU reports.
+ */
+
+#include "scanner.hpp"
+
+#include <immintrin.h>
+
+namespace scanner {
+
+namespace {
+
+// Bytes classified by each kernel call
+constexpr size_t BLOCK_SIZE = 64;
+
+// Fields of a line with the largest number of sensor pairs
+constexpr size_t MAX_FIELDS = 1 + 2 * MAX_PAIRS;
+
+// Powers of ten that are exactly representable as doubles
+constexpr double POWERS_OF_TEN[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Same powers as integers, used to join the integer and fraction digits
+constexpr uint64_t INTEGER_POWERS_OF_TEN[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+// Largest integer up to which every integer is exactly representable
+constexpr uint64_t MAX_EXACT_MANTISSA = uint64_t(1) << 53;
+
+bool isSeparator(char c) { return static_cast<unsigned char>(c) <= ' '; }
+
+/**
+ * @brief Scalar kernel: one byte at a time
+ */
+uint64_t classifyScalar(const char *block)
+{
+    uint64_t mask = 0;
+    for (size_t i = 0; i < BLOCK_SIZE; i++)
+    {
+        mask |= uint64_t(isSeparator(block[i])) << i;
+    }
+    return mask;
+}
+
+/**
+ * @brief SSE4.2 kernel: PCMPESTRM range match over 16 bytes per step
+ */
+__attribute__((target("sse4.2"))) uint64_t classifySSE42(const char *block)
+{
+    // Range [0x00, 0x20]: control characters and space
+    const __m128i range = _mm_setr_epi8(0, ' ', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                        0, 0, 0, 0);
+    uint64_t mask = 0;
+    for (size_t i = 0; i < BLOCK_SIZE; i += 16)
+    {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+        __m128i result = _mm_cmpestrm(
+            range, 2, chunk, 16,
+            _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_BIT_MASK);
+        mask |= uint64_t(uint16_t(_mm_cvtsi128_si32(result))) << i;
+    }
+    return mask;
+}
+
+/**
+ * @brief AVX2 kernel: unsigned compare of 32 bytes per step
+ */
+__attribute__((target("avx2"))) uint64_t classifyAVX2(const char *block)
+{
+    const __m256i space = _mm256_set1_epi8(' ');
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    __m256i high =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+    // x <= ' ' (unsigned) exactly when max(x, ' ') == ' '
+    uint32_t lowMask = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_max_epu8(low, space), space));
+    uint32_t highMask = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_max_epu8(high, space), space));
+    return uint64_t(lowMask) | (uint64_t(highMask) << 32);
+}
+
+/**
+ * @brief Checks that 8 bytes loaded little endian are all ASCII digits
+ */
+bool areEightDigits(uint64_t chunk)
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+            (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+           0x3333333333333333;
+}
+
+/**
+ * @brief Converts 8 ASCII digits (first digit in the lowest byte) at once
+ */
+uint64_t parseEightDigits(uint64_t chunk)
+{
+    chunk = (chunk & 0x0F0F0F0F0F0F0F0F) * 2561 >> 8;
+    chunk = (chunk & 0x00FF00FF00FF00FF) * 6553601 >> 16;
+    return (chunk & 0x0000FFFF0000FFFF) * 42949672960001 >> 32;
+}
+
+/**
+ * @brief Converts up to 8 digits, left padding them with '0'
+ * @return False if any of the bytes is not a digit
+ */
+bool parseShortDigits(const char *digits, size_t length, uint64_t &value)
+{
+    // Shift the digits in from the top so the first one ends up in byte
+    // 8 - length (same layout as a little endian load), avoiding a memcpy call
+    uint64_t chunk = 0x3030303030303030;
+    for (size_t i = 0; i < length; i++)
+    {
+        chunk = (chunk >> 8) | (uint64_t(uint8_t(digits[i])) << 56);
+    }
+    if (!areEightDigits(chunk))
+    {
+        return false;
+    }
+    value = parseEightDigits(chunk);
+    return true;
+}
+
+/**
+ * @brief Generic path: arbitrary digit counts, then strtod as last resort
+ */
+bool parseDecimalSlow(std::string_view text, double &value)
+{
+    const char *p = text.data();
+    const char *end = p + text.size();
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0, fractionDigits = 0;
+    while (p < end && *p >= '0' && *p <= '9' && digits < 19)
+    {
+        mantissa = mantissa * 10 + (*p - '0');
+        digits++;
+        p++;
+    }
+    if (p < end && (*p == '.' || *p == ','))
+    {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9' && digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits++;
+            fractionDigits++;
+            p++;
+        }
+    }
+
+    if (digits > 0 && p == end && mantissa <= MAX_EXACT_MANTISSA &&
+        fractionDigits <= 22)
+    {
+        value = static_cast<double>(mantissa) / POWERS_OF_TEN[fractionDigits];
+        value = negative ? -value : value;
+        return true;
+    }
+
+    // Exponents, very long mantissas, "nan", etc. go through strtod
+    char buffer[64];
+    if (text.empty() || text.size() >= sizeof(buffer))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        buffer[i] = text[i] == ',' ? '.' : text[i];
+    }
+    buffer[text.size()] = '\0';
+
+    char *parsedEnd = nullptr;
+    value = std::strtod(buffer, &parsedEnd);
+    return parsedEnd == buffer + text.size();
+}
+
+}
+
+Kernel bestKernel()
+{
+    static const Kernel kernel = []
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return Kernel::AVX2;
+        if (__builtin_cpu_supports("sse4.2"))
+            return Kernel::SSE42;
+        return Kernel::Scalar;
+    }();
+    return kernel;
+}
+
+const char *kernelName(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::AVX2:
+        return "avx2";
+    case Kernel::SSE42:
+        return "sse4.2";
+    default:
+        return "scalar";
+    }
+}
+
+Kernel parseKernel(const std::string &name)
+{
+    for (Kernel kernel : {Kernel::Scalar, Kernel::SSE42, Kernel::AVX2})
+    {
+        if (name != kernelName(kernel))
+            continue;
+        if (kernel > bestKernel())
+        {
+            throw std::invalid_argument("Kernel not supported by this CPU: " +
+                                        name);
+        }
+        return kernel;
+    }
+    throw std::invalid_argument("Unknown kernel: " + name);
+}
+
+bool parseDecimal(std::string_view text, double &value)
+{
+    const char *p = text.data();
+    const char *end = p + text.size();
+    bool negative = p < end && *p == '-';
+    p += negative;
+
+    // Locate the decimal separator within the first 9 characters
+    const char *separator = p;
+    while (separator < end && separator - p <= 8 && *separator != '.' &&
+           *separator != ',')
+    {
+        separator++;
+    }
+    const char *fraction = separator < end ? separator + 1 : end;
+    size_t integerLength = separator - p;
+    size_t fractionLength = end - fraction;
+
+    uint64_t integerPart = 0, fractionPart = 0;
+    if (integerLength <= 8 && fractionLength <= 8 &&
+        integerLength + fractionLength > 0 &&
+        parseShortDigits(p, integerLength, integerPart) &&
+        parseShortDigits(fraction, fractionLength, fractionPart))
+    {
+        uint64_t mantissa =
+            integerPart * INTEGER_POWERS_OF_TEN[fractionLength] + fractionPart;
+        if (mantissa <= MAX_EXACT_MANTISSA)
+        {
+            value = static_cast<double>(mantissa) /
+                    POWERS_OF_TEN[fractionLength];
+            value = negative ? -value : value;
+            return true;
+        }
+    }
+    return parseDecimalSlow(text, value);
+}
+
+FieldScanner::FieldScanner(std::string_view contents, Kernel kernel)
+    : contents(contents), blockStart(0), separators(0), fieldStart(0),
+      consumed(0), lines(0), lastLine(0)
+{
+    switch (kernel)
+    {
+    case Kernel::AVX2:
+        classify = classifyAVX2;
+        break;
+    case Kernel::SSE42:
+        classify = classifySSE42;
+        break;
+    default:
+        classify = classifyScalar;
+        break;
+    }
+    blockStart = 0 - BLOCK_SIZE; // First call to nextSeparator loads block 0
+}
+
+bool FieldScanner::nextSeparator(size_t &offset)
+{
+    while (separators == 0)
+    {
+        blockStart += BLOCK_SIZE;
+        if (blockStart >= contents.size())
+        {
+            blockStart = contents.size();
+            offset = contents.size();
+            return false;
+        }
+
+        size_t remaining = contents.size() - blockStart;
+        if (remaining >= BLOCK_SIZE)
+        {
+            separators = classify(contents.data() + blockStart);
+        }
+        else
+        {
+            // Pad the tail with non-separator bytes
+            char tail[BLOCK_SIZE];
+            std::memset(tail, 'x', BLOCK_SIZE);
+            std::memcpy(tail, contents.data() + blockStart, remaining);
+            separators = classify(tail);
+        }
+    }
+
+    offset = blockStart + __builtin_ctzll(separators);
+    separators &= separators - 1;
+    return true;
+}
+
+size_t FieldScanner::nextLine(std::string_view *fields, size_t maxFields)
+{
+    size_t count = 0;
+    while (true)
+    {
+        size_t separator;
+        bool found = nextSeparator(separator);
+
+        if (separator > fieldStart)
+        {
+            if (count < maxFields)
+            {
+                fields[count] =
+                    contents.substr(fieldStart, separator - fieldStart);
+            }
+            count++;
+        }
+        fieldStart = separator + 1;
+
+        if (!found)
+        {
+            consumed = contents.size();
+            if (count > 0)
+            {
+                lastLine = ++lines;
+            }
+            return count;
+        }
+        if (contents[separator] == '\n')
+        {
+            lines++;
+            if (count > 0)
+            {
+                consumed = fieldStart;
+                lastLine = lines;
+                return count;
+            }
+        }
+    }
+}
+
+size_t FieldScanner::position() const { return consumed; }
+
+size_t FieldScanner::lineNumber() const { return lastLine; }
+
+size_t FieldScanner::lineCount() const { return lines; }
+
+std::vector<Columns>
+parseColumns(std::string_view contents, size_t threads, Kernel kernel,
+             const std::function<void(size_t)> &onProgress, size_t lineOffset,
+             size_t sensorCount)
+{
+    // The first line tells how many sensor pairs the file has, unless an
+    // earlier part of the file already did
+    std::string_view firstFields[MAX_FIELDS];
+    FieldScanner firstLine(contents, kernel);
+    size_t fieldCount = firstLine.nextLine(firstFields, MAX_FIELDS);
+    if (fieldCount > 0 && fieldCount < 3)
+    {
+        throw std::invalid_argument(
+            "Invalid line format at line " +
+            std::to_string(lineOffset + firstLine.lineNumber()));
+    }
+    if (sensorCount == 0)
+    {
+        sensorCount = fieldCount > 0 ? (fieldCount - 1) / 2 * 2 : 2;
+    }
+    if (sensorCount > 2 * MAX_PAIRS)
+    {
+        throw std::invalid_argument("Too many sensor pairs: " +
+                                    std::to_string(sensorCount / 2));
+    }
+
+    // Split the buffer in byte ranges, moving each cut just past a newline
+    std::vector<size_t> bounds = {0};
+    for (size_t k = 1; k < std::max<size_t>(threads, 1); k++)
+    {
+        size_t cut = std::max(k * contents.size() / threads, bounds.back());
+        const void *newline = std::memchr(contents.data() + cut, '\n',
+                                          contents.size() - cut);
+        if (newline == nullptr)
+            break;
+        cut = static_cast<const char *>(newline) - contents.data() + 1;
+        if (cut > bounds.back() && cut < contents.size())
+            bounds.push_back(cut);
+    }
+    bounds.push_back(contents.size());
+    size_t ranges = bounds.size() - 1;
+
+    std::vector<Columns> chunks(ranges);
+    std::vector<size_t> lineCounts(ranges, 0), errorLines(ranges, 0);
+    std::vector<std::exception_ptr> errors(ranges);
+    std::atomic<size_t> parsedBytes(0);
+    std::mutex mutex;
+    std::condition_variable finishedRange;
+    size_t finished = 0;
+
+    auto parseRange = [&](size_t r)
+    {
+        try
+        {
+            std::string_view range =
+                contents.substr(bounds[r], bounds[r + 1] - bounds[r]);
+            FieldScanner fieldScanner(range, kernel);
+            Columns &chunk = chunks[r];
+
+            // ~8 bytes per field in the files written by LabVIEW
+            size_t expectedRows = range.size() / (8 * (sensorCount + 1));
+            chunk.time.reserve(expectedRows);
+            chunk.sensors.resize(sensorCount);
+            for (std::vector<double> &sensor : chunk.sensors)
+            {
+                sensor.reserve(expectedRows);
+            }
+
+            std::string_view fields[MAX_FIELDS];
+            size_t count, reported = 0;
+            double values[MAX_FIELDS];
+            while ((count = fieldScanner.nextLine(fields, sensorCount + 1)) > 0)
+            {
+                bool valid = count > sensorCount;
+                for (size_t k = 0; valid && k <= sensorCount; k++)
+                {
+                    valid = parseDecimal(fields[k], values[k]);
+                }
+                if (!valid)
+                {
+                    errorLines[r] = fieldScanner.lineNumber();
+                    break;
+                }
+                chunk.time.push_back(values[0]);
+                for (size_t k = 0; k < sensorCount; k++)
+                {
+                    chunk.sensors[k].push_back(values[k + 1]);
+                }
+
+                if ((chunk.size() & 0xFFF) == 0)
+                {
+                    parsedBytes += fieldScanner.position() - reported;
+                    reported = fieldScanner.position();
+                    if (ranges == 1)
+                        onProgress(parsedBytes);
+                }
+            }
+            lineCounts[r] = fieldScanner.lineCount();
+            chunk.lines = lineCounts[r];
+        }
+        catch (...)
+        {
+            errors[r] = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished++;
+        finishedRange.notify_one();
+    };
+
+    if (ranges == 1)
+    {
+        parseRange(0);
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        for (size_t r = 0; r < ranges; r++)
+        {
+            workers.emplace_back(parseRange, r);
+        }
+
+        // Report progress from this thread while the workers run
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!finishedRange.wait_for(lock, std::chrono::milliseconds(200),
+                                       [&] { return finished == ranges; }))
+        {
+            onProgress(parsedBytes);
+        }
+        lock.unlock();
+
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    // Report the first failure in file order, with its global line number
+    for (size_t r = 0; r < ranges; r++)
+    {
+        if (errors[r])
+        {
+            std::rethrow_exception(errors[r]);
+        }
+        if (errorLines[r] != 0)
+        {
+            throw std::invalid_argument(
+                "Invalid line format at line " +
+                std::to_string(lineOffset + errorLines[r]));
+        }
+        lineOffset += lineCounts[r];
+    }
+    return chunks;
+}
+
+}
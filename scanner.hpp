@@ -0,0 +1,184 @@
+/**
+ * @file scanner.hpp
+ * @brief Header file for the vectorized LVM text scanner
+ *
+ * This file provides the low level routines used to ingest .lvm text files:
+ * a field/line boundary scanner that classifies 64 bytes per step with
+ * AVX2 or SSE4.2 (selected at runtime, with a scalar fallback) and a
+ * decimal parser specialized for the fixed-precision numbers LabVIEW writes.
+ */
+
+#pragma once
+
+#include "lib.hpp"
+
+/**
+ * @namespace scanner
+ * @brief Namespace containing the LVM text scanning and parsing routines
+ */
+namespace scanner {
+
+    /**
+     * @brief Instruction set used to classify the input bytes
+     */
+    enum class Kernel
+    {
+        Scalar,
+        SSE42,
+        AVX2
+    };
+
+    /**
+     * @brief Returns the fastest kernel supported by the running CPU
+     * @return Detected kernel (computed once and cached)
+     */
+    Kernel bestKernel();
+
+    /**
+     * @brief Returns a printable name for a kernel
+     * @param kernel Kernel to name
+     * @return "scalar", "sse4.2" or "avx2"
+     */
+    const char *kernelName(Kernel kernel);
+
+    /**
+     * @brief Parses a kernel name as accepted on the command line
+     * @param name One of "scalar", "sse4.2" or "avx2"
+     * @return Matching kernel
+     * @throws std::invalid_argument if the name is unknown or the CPU
+     *         does not support the requested kernel
+     */
+    Kernel parseKernel(const std::string &name);
+
+    /**
+     * @brief Parses a decimal number accepting ',' or '.' as separator
+     *
+     * Numbers of the form [-]ddd[,.]dddddd with up to 8 digits on each side
+     * are converted with SWAR arithmetic (8 digits per multiply). Any other
+     * form falls back to a generic path. The result is always correctly
+     * rounded, i.e. identical to what strtod/istringstream return.
+     *
+     * @param text The number, without surrounding blanks
+     * @param value Output parsed value
+     * @return False if the text is not a number
+     */
+    bool parseDecimal(std::string_view text, double &value);
+
+    // Largest number of sensor pairs accepted in one file
+    constexpr size_t MAX_PAIRS = 16;
+
+    /**
+     * @struct Columns
+     * @brief Parsed samples stored column by column (SoA)
+     *
+     * Sensors are stored in pairs: sensors[2 * p] is the ring sensor and
+     * sensors[2 * p + 1] the dish sensor of pair p.
+     */
+    struct Columns
+    {
+        std::vector<double> time;                 // Timestamps
+        std::vector<std::vector<double>> sensors; // One vector per sensor column
+        size_t lines = 0;                         // Lines scanned, blank ones included
+
+        size_t size() const { return time.size(); }
+        size_t pairs() const { return sensors.size() / 2; }
+    };
+
+    /**
+     * @brief Parses a "time ring1 dish1 [ring2 dish2 ...]" text buffer with
+     *        several threads
+     *
+     * The number of sensor pairs is taken from the first non-blank line
+     * (1 + 2N fields; an odd field left over is ignored) unless it is given,
+     * and every other line must have at least as many fields.
+     * The buffer is split into one byte range per thread, each range snapped
+     * forward to the start of a line. Every thread parses its range into its
+     * own Columns chunk; concatenating the returned chunks in order yields
+     * exactly the rows a sequential parse would produce.
+     *
+     * @param contents Buffer to parse
+     * @param threads Number of threads (ranges) to use
+     * @param kernel Kernel used to classify the bytes
+     * @param onProgress Called from the calling thread with the number of
+     *        bytes parsed so far
+     * @param lineOffset Lines preceding contents in the file (e.g. a
+     *        header), added to the line numbers of errors
+     * @param sensorCount Sensor columns per line, e.g. those of an earlier
+     *        part of the same file (0 to take them from the first line)
+     * @return Parsed chunks, in file order
+     * @throws std::invalid_argument if a line has too few fields or a field
+     *         is not a number; the message carries the line number within
+     *         the whole buffer
+     */
+    std::vector<Columns>
+    parseColumns(std::string_view contents, size_t threads, Kernel kernel,
+                 const std::function<void(size_t)> &onProgress,
+                 size_t lineOffset = 0, size_t sensorCount = 0);
+
+    /**
+     * @class FieldScanner
+     * @brief Splits a text buffer into lines and blank separated fields
+     *
+     * The buffer is classified 64 bytes at a time into a bitmask of
+     * separator bytes (blanks, '\n', '\r' and any other control character);
+     * fields and line ends are then extracted by walking the set bits, so
+     * the per-byte work is done entirely by the vector kernel.
+     */
+    class FieldScanner
+    {
+    public:
+        /**
+         * @brief Creates a scanner over a buffer
+         * @param contents Buffer to scan (must outlive the scanner)
+         * @param kernel Kernel used to classify the bytes
+         */
+        explicit FieldScanner(std::string_view contents,
+                              Kernel kernel = bestKernel());
+
+        /**
+         * @brief Reads the fields of the next non-blank line
+         *
+         * Fields beyond maxFields are counted but not stored.
+         *
+         * @param fields Output array for up to maxFields field views
+         * @param maxFields Capacity of the fields array
+         * @return Number of fields in the line, 0 at the end of the buffer
+         */
+        size_t nextLine(std::string_view *fields, size_t maxFields);
+
+        /**
+         * @brief Returns the number of bytes consumed so far
+         * @return Offset just after the last returned line
+         */
+        size_t position() const;
+
+        /**
+         * @brief Returns the 1-based line number of the last returned line
+         * @return Line number, counting blank lines too
+         */
+        size_t lineNumber() const;
+
+        /**
+         * @brief Returns the number of lines scanned so far
+         * @return Line count, counting blank lines too
+         */
+        size_t lineCount() const;
+
+    private:
+        std::string_view contents;   // Buffer being scanned
+        uint64_t (*classify)(const char *); // Separator mask of 64 bytes
+        size_t blockStart;           // Offset of the current 64 byte block
+        uint64_t separators;         // Pending separator bits of the block
+        size_t fieldStart;           // Offset where the next field starts
+        size_t consumed;             // Offset after the last returned line
+        size_t lines;                // Newlines seen so far
+        size_t lastLine;             // Line number of the last returned line
+
+        /**
+         * @brief Finds the next separator byte
+         * @param offset Output offset of the separator (contents.size() at end)
+         * @return False when the buffer is exhausted
+         */
+        bool nextSeparator(size_t &offset);
+    };
+}
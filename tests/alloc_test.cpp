@@ -0,0 +1,172 @@
+/**
+ * @file alloc_test.cpp
+ * @brief Checks that DropFinder does not allocate once warm (make test)
+ *
+ * Counts the calls to operator new made by each DropFinder::findDrop call
+ * on a synthetic normalized signal (noise, drops of both polarities every
+ * 2000 rows and a stretch of NaN rows), searched the way find_drops does,
+ * both on an LVM window and on a DropWindow. Once the first window has
+ * been searched, a search that finds no candidate must not allocate at
+ * all, and one that analyzes a candidate only allocates the vectors of
+ * the Drop it returns.
+ */
+
+#include "DropFinder.hpp"
+#include "DropWindow.hpp"
+
+#include <new>
+#include <random>
+
+namespace
+{
+
+size_t allocations = 0; // Calls to operator new so far
+
+// Vectors allocated by the analysis of a candidate, all held by the Drop
+constexpr size_t DROP_VECTORS = 8;
+
+/**
+ * @brief Searches made on one kind of window
+ */
+struct Counts
+{
+    size_t empty = 0;          // Searches without a candidate
+    size_t emptyAllocs = 0;    // Allocations made by them
+    size_t analyzed = 0;       // Searches that analyzed a candidate
+    size_t analyzedAllocs = 0; // Allocations made by them
+    size_t maxAnalyzed = 0;    // Largest allocations of one of them
+};
+
+/**
+ * @brief Returns the synthetic normalized signal
+ */
+std::vector<LVM::Row> makeSignal()
+{
+    constexpr size_t ROWS = 200000;
+    constexpr size_t DROP_EVERY = 2000;
+    std::mt19937_64 random(42);
+    std::normal_distribution<double> noise(0, 0.002);
+    std::vector<LVM::Row> rows(ROWS);
+    for (size_t i = 0; i < ROWS; i++)
+    {
+        rows[i] = LVM::Row{static_cast<int64_t>(i), noise(random), noise(random), 0};
+    }
+
+    // Triangular pulses: sensor1 first, then a wider one of sensor2
+    auto pulse = [](size_t i, size_t start, size_t width, double height)
+    {
+        if (i < start || i >= start + width)
+            return 0.0;
+        double x = double(i - start) / width;
+        return height * (x < 0.5 ? 2 * x : 2 * (1 - x));
+    };
+    for (size_t start = DROP_EVERY; start + DROP_SIZE < ROWS; start += DROP_EVERY)
+    {
+        double sign = (start / DROP_EVERY) % 2 ? 1.0 : -1.0;
+        for (size_t i = start; i < start + DROP_SIZE; i++)
+        {
+            rows[i].sensor1 += pulse(i, start, 40, 0.3 * sign);
+            rows[i].sensor2 += pulse(i, start + 60, 60, 0.25 * sign);
+        }
+    }
+
+    for (size_t i = ROWS / 2; i < ROWS / 2 + 50; i++)
+    {
+        rows[i].sensor1 = NAN;
+    }
+    return rows;
+}
+
+size_t totalUsed(const LVM &window) { return window.totalUsed; }
+size_t totalUsed(const DropWindow &window) { return window.totalUsed(); }
+
+/**
+ * @brief Searches every window of the signal as find_drops does
+ * @param window Empty LVM of 2*DROP_SIZE rows or DropWindow
+ * @param dropFinder Drop detector, shared by both kinds of window
+ * @param rows Signal
+ * @return Searches made once the first window was searched
+ */
+template <typename Window>
+Counts search(Window &window, DropFinder &dropFinder, const std::vector<LVM::Row> &rows)
+{
+    Counts counts;
+    bool warm = false;
+    for (const LVM::Row &row : rows)
+    {
+        window.addSensorData(row);
+        if (window.size() != 2 * DROP_SIZE || totalUsed(window) > NN)
+            continue;
+
+        while (true)
+        {
+            size_t before = allocations;
+            Drop drop = dropFinder.findDrop(window);
+            size_t made = allocations - before;
+            if (warm && drop.c1 == -1)
+            {
+                counts.empty++;
+                counts.emptyAllocs += made;
+            }
+            else if (warm)
+            {
+                counts.analyzed++;
+                counts.analyzedAllocs += made;
+                counts.maxAnalyzed = std::max(counts.maxAnalyzed, made);
+            }
+
+            if (drop.c1 == -1)
+                break;
+            if (!drop.valid)
+            {
+                window.setUsed(drop.u1Original + drop.c1, drop.u1Original + drop.c1 + 1);
+                window.setUsed(drop.u1Original + drop.c2, drop.u1Original + drop.c2 + 1);
+                continue;
+            }
+            window.setUsed(drop.u1Original, drop.u1Original + drop.size() - 1);
+        }
+        window.setUsed(0, DROP_SIZE - 1);
+        warm = true;
+    }
+    return counts;
+}
+
+/**
+ * @brief Prints the counts of one kind of window
+ * @return False if they break the limits
+ */
+bool check(const char *name, const Counts &counts)
+{
+    std::cout << name << ": " << counts.empty << " searches without candidate, "
+              << counts.emptyAllocs << " allocations; " << counts.analyzed
+              << " analyzed, " << counts.maxAnalyzed << " allocations at most" << std::endl;
+    return counts.empty > 0 && counts.analyzed > 0 && counts.emptyAllocs == 0 &&
+           counts.maxAnalyzed <= DROP_VECTORS;
+}
+
+} // namespace
+
+void *operator new(size_t size)
+{
+    allocations++;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+int main()
+{
+    std::vector<LVM::Row> rows = makeSignal();
+    DropFinder dropFinder;
+
+    LVM lvm(2 * DROP_SIZE);
+    DropWindow window;
+    bool ok = check("LVM", search(lvm, dropFinder, rows));
+    ok = check("DropWindow", search(window, dropFinder, rows)) && ok;
+
+    std::cout << (ok ? "alloc_test passed" : "alloc_test FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file drift_test.cpp
+ * @brief Checks that the window sums of the normalizer never drift (make test)
+ *
+ * Normalizes a long synthetic signal (100M samples by default, 5.5 hours
+ * at 5000 samples per second) with the mean baseline: once with the scalar
+ * kernel on one thread and once with the AVX2 kernel, when the CPU has it,
+ * on four. Both outputs must be bit for bit those of RollingNormalizer
+ * pushed row by row.
+ *
+ * The baselines of the sensors swing across most of the +-10 V range of
+ * the ADC every few windows, so a window sums to anything between a few
+ * thousand and 5e4 V. On a plain double running sum a row is then
+ * removed at a different magnitude than it was added with (each costing
+ * up to 3.6e-12 V of rounding), so the errors no longer cancel and pile
+ * up along the signal. The mean subtracted from every 9973rd row must stay within half
+ * a unit of WindowSums (2^-41 V, plus the rounding of the mean) of the
+ * exact mean of its window, at the end of the signal as at its start,
+ * while the same windows kept with a plain running sum must go past that
+ * bound, or the test would not tell the two apart.
+ *
+ * The signal and the outputs are kept in scratch files in the temporary
+ * directory, so the test runs in little memory.
+ *
+ * Usage: drift_test [samples]
+ */
+
+#include "normalizer.hpp"
+#include "tests/synthetic_signal.hpp"
+
+namespace
+{
+
+// Largest error allowed on a window mean: half a unit of the sums, plus
+// the rounding of the mean and of the subtraction it is recovered from
+constexpr double MAX_ERROR = 0.5 / normalizer::WindowSums::VALUE_SCALE + 1e-14;
+constexpr size_t CHECK_EVERY = 9973; // Rows between two exact means
+constexpr size_t RAM_BUDGET = size_t(64) << 20;
+
+/**
+ * @brief Baselines swinging between about 0.1 and 9.9 V (about -9.9 and
+ *        -0.1 V for sensor2) plus noise
+ */
+const SyntheticSignal SIGNAL = {5, 4.9, 3.1e-4, -5, 4.9, 2.3e-4, 0.02};
+
+/**
+ * @brief Normalized output of one kernel
+ */
+struct Output
+{
+    const char *name;
+    SampleBuffer rows;
+    std::vector<int64_t> ticks;
+    std::vector<double> sensor1, sensor2;
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t samples = argc > 1 ? std::stoull(argv[1]) : 100000000;
+    std::string scratch = std::filesystem::temp_directory_path().string();
+    CLI cli;
+
+    SampleBuffer data(SampleBuffer::Precision::Double, scratch, RAM_BUDGET);
+    for (size_t i = 0; i < samples; i++)
+    {
+        data.push(SIGNAL.row(i));
+    }
+
+    std::vector<std::unique_ptr<Output>> outputs;
+    std::vector<std::pair<scanner::Kernel, size_t>> runs = {{scanner::Kernel::Scalar, 1}};
+    if (scanner::bestKernel() == scanner::Kernel::AVX2)
+    {
+        runs.push_back({scanner::Kernel::AVX2, 4});
+    }
+    else
+    {
+        std::cout << "No AVX2 on this CPU, only the scalar kernel is checked" << std::endl;
+    }
+    for (auto [kernel, threads] : runs)
+    {
+        outputs.push_back(std::make_unique<Output>(Output{
+            scanner::kernelName(kernel),
+            SampleBuffer(SampleBuffer::Precision::Double, scratch, RAM_BUDGET), {}, {}, {}}));
+        auto start = std::chrono::steady_clock::now();
+        normalizer::normalizeWithRolling(data, outputs.back()->rows, cli, DATA_PER_SECOND,
+                                         threads, kernel);
+        std::cout << outputs.back()->name << " kernel, " << threads << " threads: "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+                  << " s" << std::endl;
+    }
+
+    // Single pass over the outputs, against RollingNormalizer and the
+    // exact means of some windows
+    size_t halfWindow = normalizer::RollingNormalizer::halfWindowFor(DATA_PER_SECOND);
+    size_t windowSize = 2 * halfWindow + 1;
+    normalizer::RollingNormalizer reference;
+    size_t mismatches = 0, produced = 0;
+    double maxError = 0, maxPlainError = 0, plainSum = 0;
+    for (size_t i = 0; i < samples; i++)
+    {
+        LVM::Row row = SIGNAL.row(i), normalized;
+        plainSum += row.sensor1;
+        if (i >= windowSize)
+        {
+            plainSum -= SIGNAL.row(i - windowSize).sensor1;
+        }
+        if (!reference.push(row, normalized))
+            continue;
+
+        size_t k = produced++;
+        size_t offset = k % normalizer::BLOCK_ROWS;
+        for (std::unique_ptr<Output> &output : outputs)
+        {
+            if (offset == 0)
+            {
+                size_t count = std::min(normalizer::BLOCK_ROWS, output->rows.size() - k);
+                output->ticks.resize(count);
+                output->sensor1.resize(count);
+                output->sensor2.resize(count);
+                output->rows.read(k, count, output->ticks.data(), output->sensor1.data(),
+                                  output->sensor2.data());
+            }
+            if (output->ticks[offset] != normalized.tick ||
+                output->sensor1[offset] != normalized.sensor1 ||
+                output->sensor2[offset] != normalized.sensor2)
+            {
+                if (mismatches++ == 0)
+                    std::cout << output->name << " differs from RollingNormalizer at row " << k
+                              << std::endl;
+            }
+        }
+
+        if (k % CHECK_EVERY == 0 || i + 1 == samples)
+        {
+            long double exact = 0;
+            for (size_t j = k; j < k + windowSize; j++)
+            {
+                exact += SIGNAL.row(j).sensor1;
+            }
+            exact /= windowSize;
+            double mean = SIGNAL.row(k + halfWindow).sensor1 - normalized.sensor1;
+            maxError = std::max(maxError, double(std::fabs(mean - exact)));
+            maxPlainError = std::max(maxPlainError, double(std::fabs(plainSum / windowSize - exact)));
+        }
+    }
+
+    std::cout << std::scientific << std::setprecision(2) << produced
+              << " rows normalized, largest error of a window mean "
+              << maxError << " V (bound " << MAX_ERROR << " V, plain double running sum: "
+              << maxPlainError << " V)" << std::endl;
+    bool ok = mismatches == 0 && maxError <= MAX_ERROR && maxPlainError > MAX_ERROR &&
+              produced == outputs.front()->rows.size() &&
+              produced == outputs.back()->rows.size();
+    std::cout << (ok ? "drift_test passed" : "drift_test FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file synthetic_signal.hpp
+ * @brief Synthetic sensor signal shared by the tests and the benchmarks
+ *
+ * Every row is computed from its index alone, so a program can generate
+ * the same signal again (e.g. to check its output) without storing it.
+ */
+
+#pragma once
+
+#include "LVM.hpp"
+
+/**
+ * @struct SyntheticSignal
+ * @brief Baselines drifting around an offset, noise and optional drops
+ *
+ * sensor1 = offset1 + swing1 * sin(i * rate1) + noise, and sensor2 the same
+ * with its own parameters and a cosine. With dropEvery set, a triangular
+ * drop of DROP_HEIGHT1 V over 40 rows on sensor1, followed by one of
+ * DROP_HEIGHT2 V over 60 rows on sensor2, starts every dropEvery rows.
+ * Values are rounded to the 1e-6 V of the .lvm files.
+ */
+struct SyntheticSignal
+{
+    static constexpr double DROP_HEIGHT1 = 0.3;  // Height of the sensor1 drops (V)
+    static constexpr double DROP_HEIGHT2 = 0.25; // Height of the sensor2 drops (V)
+
+    double offset1, swing1, rate1; // Baseline of sensor1
+    double offset2, swing2, rate2; // Baseline of sensor2
+    double noise;                  // Peak to peak amplitude of the noise (V)
+    size_t dropEvery = 0;          // Rows between two drops (0: no drops)
+
+    /**
+     * @brief Returns a pseudo-random value in [-0.5, 0.5) for an index (splitmix64)
+     */
+    static double random(uint64_t i)
+    {
+        uint64_t z = i + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z ^= z >> 31;
+        return double(z >> 11) / 9007199254740992.0 - 0.5;
+    }
+
+    /**
+     * @brief Returns row i of the signal, with i as its tick
+     */
+    LVM::Row row(size_t i) const
+    {
+        double sensor1 = offset1 + swing1 * std::sin(i * rate1) + noise * random(2 * i);
+        double sensor2 = offset2 + swing2 * std::cos(i * rate2) + noise * random(2 * i + 1);
+        if (dropEvery > 0)
+        {
+            size_t phase = i % dropEvery;
+            if (phase < 40)
+                sensor1 += DROP_HEIGHT1 * (1 - std::fabs(phase - 20.0) / 20);
+            if (phase >= 60 && phase < 120)
+                sensor2 += DROP_HEIGHT2 * (1 - std::fabs(phase - 90.0) / 30);
+        }
+        return LVM::Row{static_cast<int64_t>(i), std::round(sensor1 * 1e6) / 1e6,
+                        std::round(sensor2 * 1e6) / 1e6, 0};
+    }
+};